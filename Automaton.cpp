@@ -1,6 +1,9 @@
 #include "Automaton.h"
 
 #include <bits/fs_fwd.h>
+#include <limits>
+#include <regex>
+#include <stdexcept>
 
 using namespace automaton;
 
@@ -30,15 +33,19 @@ std::unordered_map<T, U, Hash> TieMaps(const std::unordered_map<T, U, Hash>& map
     return mergedMap;
 }
 
+bool IsSymbol(char character) {
+    return ('a' <= character && character <= 'z')
+           || ('A' <= character && character <= 'Z')
+           || ('0' <= character && character <= '9');
+}
+
 std::string RegexToPolishForm(const std::string &regex) {
     std::stack<char> operationStack;
     std::string output;
 
     for (size_t i = 0; i < regex.size(); ++i) {
         const char character = regex[i];
-        if (('0' <= character and character <= '9')
-            or ('a' <= character and character <= 'z')
-            or ('A' <= character and character <= 'Z')) {
+        if (IsSymbol(character)) {
             output.push_back(character);
             } else {
                 if (character == '(') {
@@ -210,3 +217,110 @@ bool Automaton::VerifyAutomaton() const {
 
     return true;
 }
+
+Automaton* automaton::BuildAutomaton(const std::string& regex)
+{
+    std::string polishFormRegex = RegexToPolishForm(regex);
+    std::stack<Automaton*> automatonStack;
+    std::uint16_t counter = 0;
+    //every symbol and operator gets two state numbers
+    if (polishFormRegex.size() > std::numeric_limits<state>::max() / 2)
+        throw std::length_error("regex is too long for the automaton");
+
+    //exciting stuff here!!
+
+    for(char character : polishFormRegex)
+    {
+        if(IsSymbol(character))
+        {
+            std::uint16_t next = counter + 1;
+            auto* automat = new Automaton{counter, next, character};
+            automatonStack.push(automat);
+        }
+
+        if(character == '*')
+        {
+            auto A = automatonStack.top();
+            automatonStack.pop();
+            auto* C = new Automaton{counter, static_cast<state>(counter + 1)};
+            C->Kleene(*A);
+            delete A;
+            automatonStack.push(C);
+        }
+
+        if(character == '.')
+        {
+            auto B = automatonStack.top();
+            automatonStack.pop();
+            auto A = automatonStack.top();
+            automatonStack.pop();
+
+            auto* C = new Automaton{*A, *B};
+            delete A;
+            delete B;
+            automatonStack.push(C);
+        }
+
+        if(character == '|')
+        {
+            auto B = automatonStack.top();
+            automatonStack.pop();
+            auto A = automatonStack.top();
+            automatonStack.pop();
+
+            auto* C = new Automaton{counter, static_cast<state>(counter + 1)};
+            C->TieAutomatons(*A, *B);
+            delete A;
+            delete B;
+            automatonStack.push(C);
+        }
+        counter += 2;
+    }
+
+    auto* finalAutomaton = automatonStack.top();
+    automatonStack.pop();
+    return finalAutomaton;
+}
+
+std::string ParsingRegex(const std::string& regex) {
+    std::string result = "";
+    for (auto character : regex) {
+        if (character != '.') {
+            result += character;
+        }
+    }
+    return result;
+}
+
+bool ValidateRegex(const std::string& regex) {
+    if (regex.empty()) {
+        return false;
+    }
+    std::string toCheck = ParsingRegex(regex);
+    try {
+        std::regex re(toCheck);
+    }
+    catch (std::regex_error& e) {
+        return false;
+    }
+    //std::regex is more permissive than BuildAutomaton ("ab", "a|"), so also check the postfix form is a single operand
+    int operands = 0;
+    for (char character : RegexToPolishForm(regex)) {
+        if (IsSymbol(character)) {
+            operands += 1;
+        }
+        else if (character == '*') {
+            if (operands < 1)
+                return false;
+        }
+        else if (character == '.' || character == '|') {
+            if (operands < 2)
+                return false;
+            operands -= 1;
+        }
+        else {
+            return false;
+        }
+    }
+    return operands == 1;
+}
@@ -10,7 +10,11 @@
 #include <variant>
 #include <algorithm>
 
+//the symbols a regex is written with: ASCII letters and digits, everything else is an operator
+bool IsSymbol(char character);
 std::string RegexToPolishForm(const std::string &regex);
+std::string ParsingRegex(const std::string& regex);
+bool ValidateRegex(const std::string& regex);
 
 namespace automaton
 {
@@ -58,5 +62,7 @@ namespace automaton
 
     std::ostream& operator << (std::ostream& os, const Automaton& automaton);
 
+    Automaton* BuildAutomaton(const std::string& regex);
+
 }
 
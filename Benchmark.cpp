@@ -0,0 +1,337 @@
+#include "Benchmark.h"
+#include "Matcher.h"
+#include "Capture.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace automaton;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    //hardware cache read misses of this thread, unavailable when perf events are not permitted
+    class CacheMissCounter
+    {
+    public:
+        explicit CacheMissCounter(std::uint64_t cache)
+        {
+            perf_event_attr attributes{};
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.size = sizeof(attributes);
+            attributes.config = cache
+                                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        CacheMissCounter(const CacheMissCounter&) = delete;
+        CacheMissCounter& operator = (const CacheMissCounter&) = delete;
+
+        ~CacheMissCounter()
+        {
+            if (m_fd >= 0)
+                close(m_fd);
+        }
+
+        void Start()
+        {
+            if (m_fd < 0)
+                return;
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        std::optional<std::uint64_t> Stop()
+        {
+            if (m_fd < 0)
+                return std::nullopt;
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t value;
+            if (read(m_fd, &value, sizeof(value)) != sizeof(value))
+                return std::nullopt;
+            return value;
+        }
+
+    private:
+        int m_fd;
+    };
+
+    std::string FormatCount(std::optional<std::uint64_t> count)
+    {
+        return count ? std::to_string(*count) : "n/a";
+    }
+
+    //the corpus split into lines, the records point into corpus
+    bool LoadCorpus(const std::string& corpusPath, std::string& corpus, std::vector<std::string_view>& records)
+    {
+        std::ifstream corpusFile(corpusPath, std::ios::binary);
+        if (!corpusFile.is_open()) {
+            std::cerr << "Error opening file " << corpusPath << std::endl;
+            return false;
+        }
+        std::stringstream contents;
+        contents << corpusFile.rdbuf();
+        corpus = contents.str();
+
+        for (std::string_view rest = corpus; !rest.empty();) {
+            auto newline = rest.find('\n');
+            records.push_back(rest.substr(0, newline));
+            rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+        }
+        return true;
+    }
+
+    //the union of an automaton with itself comes back minimized; unions stay within 16-bit states, which a trie of
+    //a long word list outgrows
+    std::string MinimalStateCount(const Matcher& matcher)
+    {
+        try {
+            return std::to_string(Matcher::Union(matcher, matcher).StateCount());
+        }
+        catch (const std::length_error&) {
+            return "n/a";
+        }
+    }
+}
+
+int automaton::BenchmarkLayouts(const std::string& regex, const std::string& corpusPath, bool wholeRecord, const CompileOptions& options)
+{
+    std::string corpus;
+    std::vector<std::string_view> records;
+    if (!LoadCorpus(corpusPath, corpus, records))
+        return 2;
+
+    //the profile must not be trained on the records it is measured on; without a sample it gets the first
+    //tenth of the corpus and every layout is measured on the rest
+    std::string_view sample = options.sample;
+    std::size_t measuredBytes = corpus.size();
+    if (sample.empty() && records.size() >= 10) {
+        auto firstMeasured = records.begin() + records.size() / 10;
+        sample = std::string_view(corpus).substr(0, firstMeasured->data() - corpus.data());
+        measuredBytes -= sample.size();
+        records.erase(records.begin(), firstMeasured);
+    }
+
+    struct Candidate
+    {
+        const char* name;
+        Layout layout;
+    };
+    const Candidate candidates[] = {
+        {"original", Layout::Original},
+        {"bfs", Layout::BreadthFirst},
+        {"profile", Layout::Profile},
+    };
+    //the automaton is built once, every candidate only renumbers a copy of it
+    std::optional<Matcher> original;
+    try {
+        original.emplace(CompileRegex(regex, {Layout::Original, {}, options.engine}));
+    }
+    catch (const std::length_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    CacheMissCounter l1Misses(PERF_COUNT_HW_CACHE_L1D);
+    CacheMissCounter lastLevelMisses(PERF_COUNT_HW_CACHE_LL);
+    double megabytes = static_cast<double>(measuredBytes) / (1024.0 * 1024.0);
+    std::cout << std::format("profile trained on {}, {:.1f} MB measured\n",
+                             options.sample.empty() ? "the first tenth of the corpus" : "the --profile sample",
+                             megabytes);
+    std::cout << std::format("{:<10}{:>8}{:>10}{:>10}{:>16}{:>16}\n", "layout", "states", "matches", "MB/s", "L1d misses", "LLC misses");
+
+    for (const auto& candidate : candidates) {
+        auto matcher = *original;
+        matcher.ApplyLayout(candidate.layout, sample);
+        constexpr int runs = 3;
+        double best = 0.0;
+        std::size_t matches = 0;
+        std::optional<std::uint64_t> bestL1;
+        std::optional<std::uint64_t> bestLastLevel;
+        for (int run = 0; run < runs; ++run) {
+            matches = 0;
+            l1Misses.Start();
+            lastLevelMisses.Start();
+            auto start = Clock::now();
+            for (auto record : records) {
+                matches += wholeRecord ? matcher.Match(record) : matcher.Search(record);
+            }
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            auto l1 = l1Misses.Stop();
+            auto lastLevel = lastLevelMisses.Stop();
+            double throughput = elapsed.count() > 0 ? megabytes / elapsed.count() : 0.0;
+            if (throughput >= best) {
+                best = throughput;
+                bestL1 = l1;
+                bestLastLevel = lastLevel;
+            }
+        }
+        std::cout << std::format("{:<10}{:>8}{:>10}{:>10.1f}{:>16}{:>16}\n",
+                                 candidate.name,
+                                 matcher.StateCount(),
+                                 matches,
+                                 best,
+                                 FormatCount(bestL1),
+                                 FormatCount(bestLastLevel));
+    }
+    return 0;
+}
+
+int automaton::BenchmarkEngines(const std::vector<std::string>& patterns)
+{
+    struct Candidate
+    {
+        const char* name;
+        Engine engine;
+    };
+    const Candidate candidates[] = {
+        {"thompson", Engine::Thompson},
+        {"derivative", Engine::Derivative},
+        {"glushkov", Engine::Glushkov},
+    };
+
+    std::cout << std::format("{:<8}{:<12}{:>12}{:>12}{:>12}\n", "pattern", "engine", "DFA states", "minimal", "build ms");
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        for (const auto& candidate : candidates) {
+            constexpr int runs = 3;
+            double best = std::numeric_limits<double>::max();
+            std::size_t states = 0;
+            std::optional<Matcher> matcher;
+            try {
+                for (int run = 0; run < runs; ++run) {
+                    auto start = Clock::now();
+                    auto dfa = BuildDeterministicAutomaton(patterns[i], candidate.engine);
+                    matcher.emplace(dfa);
+                    matcher->BuildSearchTable();
+                    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+                    best = std::min(best, elapsed.count());
+                    states = dfa.GetStates().size();
+                }
+            }
+            catch (const std::length_error& e) {
+                std::cout << std::format("{:<8}{:<12}{}\n", i + 1, candidate.name, e.what());
+                continue;
+            }
+            //all engines have to agree on the minimal automaton
+            std::cout << std::format("{:<8}{:<12}{:>12}{:>12}{:>12.3f}\n",
+                                     i + 1,
+                                     candidate.name,
+                                     states,
+                                     MinimalStateCount(*matcher),
+                                     best);
+        }
+
+        //word lists also get the trie CompileRegex builds for them
+        auto literals = ExtractLiterals(patterns[i]);
+        if (!literals)
+            continue;
+        double best = std::numeric_limits<double>::max();
+        std::optional<Matcher> matcher;
+        try {
+            for (int run = 0; run < 3; ++run) {
+                auto start = Clock::now();
+                matcher.emplace(Matcher::FromLiterals(*ExtractLiterals(patterns[i])));
+                std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+        }
+        catch (const std::length_error& e) {
+            std::cout << std::format("{:<8}{:<12}{}\n", i + 1, "trie", e.what());
+            continue;
+        }
+        std::cout << std::format("{:<8}{:<12}{:>12}{:>12}{:>12.3f}\n",
+                                 i + 1,
+                                 "trie",
+                                 matcher->StateCount(),
+                                 MinimalStateCount(*matcher),
+                                 best);
+    }
+    return 0;
+}
+
+int automaton::BenchmarkExtraction(const std::string& regex, const std::string& corpusPath)
+{
+    std::string corpus;
+    std::vector<std::string_view> records;
+    if (!LoadCorpus(corpusPath, corpus, records))
+        return 2;
+
+    CaptureMatcher tagged(regex);
+    std::regex reference(ParsingRegex(regex));
+    std::vector<std::vector<Capture>> taggedGroups(records.size());
+    std::vector<std::vector<Capture>> referenceGroups(records.size());
+
+    auto runTagged = [&] {
+        std::vector<Capture> groups;
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            taggedGroups[i].clear();
+            if (tagged.Match(records[i], groups))
+                taggedGroups[i] = groups;
+        }
+    };
+    auto runReference = [&] {
+        std::cmatch groups;
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            referenceGroups[i].clear();
+            if (!std::regex_match(records[i].data(), records[i].data() + records[i].size(), groups, reference))
+                continue;
+            for (const auto& group : groups) {
+                if (group.matched)
+                    referenceGroups[i].push_back({static_cast<std::size_t>(group.first - records[i].data()),
+                                                  static_cast<std::size_t>(group.second - records[i].data())});
+                else referenceGroups[i].push_back({});
+            }
+        }
+    };
+    struct Candidate
+    {
+        const char* name;
+        std::function<void()> run;
+        const std::vector<std::vector<Capture>>& groups;
+    };
+    const Candidate candidates[] = {
+        {"tdfa", runTagged, taggedGroups},
+        {"std::regex", runReference, referenceGroups},
+    };
+
+    double megabytes = static_cast<double>(corpus.size()) / (1024.0 * 1024.0);
+    std::cout << std::format("{} groups, {} tagged DFA states\n", tagged.GroupCount(), tagged.StateCount());
+    std::cout << std::format("{:<12}{:>10}{:>10}\n", "engine", "matches", "MB/s");
+    for (const auto& candidate : candidates) {
+        constexpr int runs = 3;
+        double best = 0.0;
+        for (int run = 0; run < runs; ++run) {
+            auto start = Clock::now();
+            candidate.run();
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            best = std::max(best, elapsed.count() > 0 ? megabytes / elapsed.count() : 0.0);
+        }
+        auto matches = std::count_if(candidate.groups.begin(), candidate.groups.end(), [](const auto& groups) { return !groups.empty(); });
+        std::cout << std::format("{:<12}{:>10}{:>10.1f}\n", candidate.name, matches, best);
+    }
+
+    std::size_t differences = 0;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        auto same = [](const Capture& first, const Capture& second) { return first.begin == second.begin && first.end == second.end; };
+        if (!std::equal(taggedGroups[i].begin(), taggedGroups[i].end(), referenceGroups[i].begin(), referenceGroups[i].end(), same))
+            differences += 1;
+    }
+    std::cout << std::format("records with different groups: {}\n", differences);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Matcher.h"
+#include <string>
+#include <vector>
+
+namespace automaton
+{
+    //scans the corpus with every row layout and prints throughput next to L1d and last-level cache read misses;
+    //the automaton comes from options.engine and the profile layout is trained on options.sample
+    int BenchmarkLayouts(const std::string& regex, const std::string& corpusPath, bool wholeRecord, const CompileOptions& options);
+    //builds every pattern with every engine and prints DFA and minimal DFA state counts next to the time
+    //from the regex to a ready Matcher, word lists also get a row for the Aho-Corasick trie
+    int BenchmarkEngines(const std::vector<std::string>& patterns);
+    //extracts the groups of every whole-line match with the tagged DFA and with std::regex, and reports
+    //the throughput of both and the lines where they disagree
+    int BenchmarkExtraction(const std::string& regex, const std::string& corpusPath);
+}
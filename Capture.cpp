@@ -0,0 +1,421 @@
+#include "Capture.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace automaton;
+
+namespace
+{
+    struct Expression
+    {
+        enum class Kind : std::uint8_t { Symbol, Concat, Union, Star, Group } kind;
+        char symbol = 0;
+        std::size_t left = 0;
+        std::size_t right = 0;
+        std::size_t group = 0;
+    };
+
+    //recursive descent over the infix regex, since the postfix form has lost the parentheses
+    class Parser
+    {
+    public:
+        explicit Parser(const std::string& regex)
+            : m_regex{regex}
+        {
+        }
+
+        std::size_t Parse()
+        {
+            auto root = ParseUnion();
+            if (m_position != m_regex.size())
+                throw std::invalid_argument("unexpected " + std::string(1, m_regex[m_position]) + " in " + m_regex);
+            return root;
+        }
+
+        const std::vector<Expression>& GetExpressions() const
+        {
+            return m_expressions;
+        }
+
+        std::size_t GetGroupCount() const
+        {
+            return m_groups;
+        }
+
+    private:
+        std::size_t ParseUnion()
+        {
+            auto left = ParseConcat();
+            while (Accept('|')) {
+                auto right = ParseConcat();
+                left = Add({Expression::Kind::Union, 0, left, right});
+            }
+            return left;
+        }
+
+        std::size_t ParseConcat()
+        {
+            auto left = ParseStar();
+            while (Accept('.')) {
+                auto right = ParseStar();
+                left = Add({Expression::Kind::Concat, 0, left, right});
+            }
+            return left;
+        }
+
+        std::size_t ParseStar()
+        {
+            auto operand = ParseAtom();
+            while (Accept('*')) {
+                operand = Add({Expression::Kind::Star, 0, operand});
+            }
+            return operand;
+        }
+
+        std::size_t ParseAtom()
+        {
+            if (Accept('(')) {
+                auto group = ++m_groups;
+                auto inner = ParseUnion();
+                if (!Accept(')'))
+                    throw std::invalid_argument("missing ) in " + m_regex);
+                return Add({Expression::Kind::Group, 0, inner, 0, group});
+            }
+            if (m_position < m_regex.size() && IsSymbol(m_regex[m_position]))
+                return Add({Expression::Kind::Symbol, m_regex[m_position++]});
+            throw std::invalid_argument("expected a symbol or ( in " + m_regex);
+        }
+
+        bool Accept(char character)
+        {
+            if (m_position < m_regex.size() && m_regex[m_position] == character) {
+                m_position += 1;
+                return true;
+            }
+            return false;
+        }
+
+        std::size_t Add(const Expression& expression)
+        {
+            m_expressions.push_back(expression);
+            return m_expressions.size() - 1;
+        }
+
+    private:
+        const std::string& m_regex;
+        std::size_t m_position = 0;
+        std::size_t m_groups = 0;
+        std::vector<Expression> m_expressions;
+    };
+
+    //Thompson NFA whose lambda-edges are ordered by priority and may carry tags; group k has the tags 2k-2 and 2k-1
+    struct Node
+    {
+        enum class Kind : std::uint8_t { Symbol, Split, Loop, Tag, Accept } kind;
+        char symbol = 0;
+        std::uint32_t next = 0;
+        std::uint32_t alternative = 0;  //Split and Loop: the branch taken with lower priority
+        std::uint32_t tag = 0;
+    };
+
+    class TaggedAutomaton
+    {
+    public:
+        TaggedAutomaton(const std::vector<Expression>& expressions, std::size_t root)
+            : m_expressions{expressions}
+        {
+            auto accept = Add({Node::Kind::Accept});
+            m_start = Compile(root, accept);
+        }
+
+        const std::vector<Node>& GetNodes() const
+        {
+            return m_nodes;
+        }
+
+        std::uint32_t GetStart() const
+        {
+            return m_start;
+        }
+
+    private:
+        //the automaton of an expression followed by next
+        std::uint32_t Compile(std::size_t index, std::uint32_t next)
+        {
+            const auto& expression = m_expressions[index];
+            switch (expression.kind) {
+                case Expression::Kind::Symbol:
+                    return Add({Node::Kind::Symbol, expression.symbol, next});
+                case Expression::Kind::Concat:
+                    return Compile(expression.left, Compile(expression.right, next));
+                case Expression::Kind::Union: {
+                    auto left = Compile(expression.left, next);
+                    auto right = Compile(expression.right, next);
+                    return Add({Node::Kind::Split, 0, left, right});
+                }
+                case Expression::Kind::Star: {
+                    auto loop = Add({Node::Kind::Loop});
+                    auto body = Compile(expression.left, loop);
+                    m_nodes[loop].next = body;
+                    m_nodes[loop].alternative = next;
+                    return loop;
+                }
+                case Expression::Kind::Group: {
+                    auto tag = static_cast<std::uint32_t>(2 * expression.group - 2);
+                    auto close = Add({Node::Kind::Tag, 0, next, 0, tag + 1});
+                    return Add({Node::Kind::Tag, 0, Compile(expression.left, close), 0, tag});
+                }
+            }
+            return next;
+        }
+
+        std::uint32_t Add(const Node& node)
+        {
+            m_nodes.push_back(node);
+            return static_cast<std::uint32_t>(m_nodes.size() - 1);
+        }
+
+    private:
+        const std::vector<Expression>& m_expressions;
+        std::vector<Node> m_nodes;
+        std::uint32_t m_start;
+    };
+
+    //a thread of a DFA state: the symbol or accepting node it waits in, the thread of the previous state it
+    //continues and the tags it set on the way
+    struct Thread
+    {
+        std::uint32_t node;
+        std::uint32_t source;
+        std::vector<std::uint32_t> tags;
+    };
+
+    //lambda-closure in priority order; a node reached by a higher priority thread first is not entered again,
+    //which is what keeps the leftmost-greedy choice
+    //a loop reached again through its own body had an empty iteration, which ends the loop like in std::regex
+    class Closure
+    {
+    public:
+        explicit Closure(const std::vector<Node>& nodes)
+            : m_nodes{nodes}
+            , m_visited(nodes.size(), 0)
+        {
+        }
+
+        void Begin()
+        {
+            m_generation += 1;
+            m_threads.clear();
+        }
+
+        void Follow(std::uint32_t node, std::uint32_t source)
+        {
+            const auto& current = m_nodes[node];
+            if (m_visited[node] == m_generation) {
+                if (current.kind == Node::Kind::Loop)
+                    Follow(current.alternative, source);
+                return;
+            }
+            m_visited[node] = m_generation;
+            switch (current.kind) {
+                case Node::Kind::Symbol:
+                case Node::Kind::Accept:
+                    m_threads.push_back({node, source, m_path});
+                    break;
+                case Node::Kind::Split:
+                case Node::Kind::Loop:
+                    Follow(current.next, source);
+                    Follow(current.alternative, source);
+                    break;
+                case Node::Kind::Tag:
+                    m_path.push_back(current.tag);
+                    Follow(current.next, source);
+                    m_path.pop_back();
+                    break;
+            }
+        }
+
+        const std::vector<Thread>& GetThreads() const
+        {
+            return m_threads;
+        }
+
+    private:
+        const std::vector<Node>& m_nodes;
+        std::vector<std::uint32_t> m_visited;
+        std::uint32_t m_generation = 0;
+        std::vector<std::uint32_t> m_path;
+        std::vector<Thread> m_threads;
+    };
+}
+
+CaptureMatcher::CaptureMatcher(const std::string& regex)
+{
+    Parser parser(regex);
+    auto root = parser.Parse();
+    m_groups = parser.GetGroupCount();
+    m_tags = 2 * m_groups;
+    TaggedAutomaton nfa(parser.GetExpressions(), root);
+    const auto& nodes = nfa.GetNodes();
+
+    for (const auto& node : nodes) {
+        if (node.kind != Node::Kind::Symbol || m_classes[static_cast<unsigned char>(node.symbol)] != 0)
+            continue;
+        m_classes[static_cast<unsigned char>(node.symbol)] = static_cast<std::uint8_t>(m_columns);
+        m_columns += 1;
+    }
+
+    //a state is its threads plus the registers that hold their tags; registers are numbered in order of first
+    //use, so two states that only differ by the names of their registers are the same state
+    constexpr std::uint32_t unset = 0xFFFFFFFF;
+    constexpr std::uint32_t fresh = 0x80000000;
+    std::map<std::vector<std::uint32_t>, state> indices{{{}, 0}};
+    std::vector<std::vector<std::uint32_t>> stateNodes{{}};
+    std::vector<std::vector<std::uint32_t>> stateRegisters{{}};
+    std::vector<bool> stored(m_tags);
+    //the transition into the threads, every tag stored along the way goes into one new register for all threads
+    //and the other registers come from the thread that was continued
+    auto intern = [&](const std::vector<Thread>& threads, const std::vector<std::uint32_t>& sourceRegisters, std::vector<Action>& actions) {
+        std::vector<std::uint32_t> key;
+        std::vector<std::uint32_t> registers;
+        std::unordered_map<std::uint32_t, std::uint32_t> renumbered;
+        bool copies = false;
+        for (const auto& thread : threads) {
+            key.push_back(thread.node);
+            std::fill(stored.begin(), stored.end(), false);
+            for (auto tag : thread.tags) {
+                stored[tag] = true;
+            }
+            for (std::uint32_t tag = 0; tag < m_tags; ++tag) {
+                auto value = stored[tag] ? fresh + tag
+                             : sourceRegisters.empty() ? unset
+                             : sourceRegisters[thread.source * m_tags + tag];
+                if (value == unset) {
+                    registers.push_back(unset);
+                    continue;
+                }
+                auto [it, inserted] = renumbered.try_emplace(value, static_cast<std::uint32_t>(renumbered.size()));
+                if (inserted && value >= fresh) {
+                    actions.push_back({it->second, storePosition});
+                }
+                else if (inserted && value != it->second) {
+                    actions.push_back({it->second, value});
+                    copies = true;
+                }
+                registers.push_back(it->second);
+            }
+        }
+        m_registers = std::max(m_registers, renumbered.size());
+        key.insert(key.end(), registers.begin(), registers.end());
+
+        auto [it, inserted] = indices.try_emplace(std::move(key), static_cast<state>(stateNodes.size()));
+        if (inserted) {
+            if (stateNodes.size() >= std::numeric_limits<state>::max())
+                throw std::length_error("tagged automaton has too many states");
+            stateNodes.emplace_back();
+            for (const auto& thread : threads) {
+                stateNodes.back().push_back(thread.node);
+            }
+            stateRegisters.push_back(std::move(registers));
+        }
+        return std::pair{it->second, copies};
+    };
+
+    Closure closure(nodes);
+    closure.Begin();
+    closure.Follow(nfa.GetStart(), 0);
+    m_start = intern(closure.GetThreads(), {}, m_initialActions).first;
+
+    m_actionBegin.push_back(0);
+    for (std::size_t current = 0; current < stateNodes.size(); ++current) {
+        m_next.resize((current + 1) * m_columns, 0);
+        for (std::size_t column = 0; column < m_columns; ++column) {
+            closure.Begin();
+            if (column != 0) {
+                for (std::uint32_t thread = 0; thread < stateNodes[current].size(); ++thread) {
+                    const auto& node = nodes[stateNodes[current][thread]];
+                    if (node.kind == Node::Kind::Symbol && m_classes[static_cast<unsigned char>(node.symbol)] == column)
+                        closure.Follow(node.next, thread);
+                }
+            }
+            bool copies = false;
+            if (!closure.GetThreads().empty()) {
+                auto sourceRegisters = stateRegisters[current];
+                auto [target, copied] = intern(closure.GetThreads(), sourceRegisters, m_actions);
+                m_next[current * m_columns + column] = target;
+                copies = copied;
+            }
+            m_copies.push_back(copies);
+            m_actionBegin.push_back(static_cast<std::uint32_t>(m_actions.size()));
+        }
+
+        //the tags of the highest priority thread that accepts
+        std::size_t accept = 0;
+        while (accept < stateNodes[current].size() && nodes[stateNodes[current][accept]].kind != Node::Kind::Accept) {
+            accept += 1;
+        }
+        m_accepting.push_back(accept < stateNodes[current].size());
+        for (std::size_t tag = 0; tag < m_tags; ++tag) {
+            m_acceptRegisters.push_back(m_accepting.back() ? stateRegisters[current][accept * m_tags + tag] : unset);
+        }
+    }
+}
+
+void CaptureMatcher::ApplyActions(const Action* first, const Action* last, bool copies, std::size_t position,
+                                  std::vector<std::size_t>& registers, std::vector<std::size_t>& scratch)
+{
+    //every register is written at most once per transition, copies read the values from before it
+    if (copies)
+        std::copy(registers.begin(), registers.end(), scratch.begin());
+    for (; first != last; ++first) {
+        registers[first->target] = first->source == storePosition ? position : scratch[first->source];
+    }
+}
+
+bool CaptureMatcher::Match(std::string_view text, std::vector<Capture>& groups) const
+{
+    //a register is only read after it was written during this match, so they are not cleared
+    thread_local std::vector<std::size_t> registers;
+    thread_local std::vector<std::size_t> scratch;
+    registers.resize(m_registers);
+    scratch.resize(m_registers);
+    ApplyActions(m_initialActions.data(), m_initialActions.data() + m_initialActions.size(), false, 0, registers, scratch);
+
+    state current = m_start;
+    for (std::size_t position = 0; position < text.size(); ++position) {
+        std::size_t transition = current * m_columns + m_classes[static_cast<unsigned char>(text[position])];
+        current = m_next[transition];
+        if (current == 0)
+            return false;
+        if (m_actionBegin[transition] != m_actionBegin[transition + 1]) {
+            ApplyActions(m_actions.data() + m_actionBegin[transition], m_actions.data() + m_actionBegin[transition + 1],
+                         m_copies[transition], position + 1, registers, scratch);
+        }
+    }
+
+    if (!m_accepting[current])
+        return false;
+    groups.assign(m_groups + 1, {});
+    groups[0] = {0, text.size()};
+    const auto* tags = m_acceptRegisters.data() + current * m_tags;
+    for (std::size_t group = 1; group <= m_groups; ++group) {
+        auto begin = tags[2 * group - 2];
+        auto end = tags[2 * group - 1];
+        if (begin < m_registers && end < m_registers)
+            groups[group] = {registers[begin], registers[end]};
+    }
+    return true;
+}
+
+std::size_t CaptureMatcher::GroupCount() const
+{
+    return m_groups;
+}
+
+std::size_t CaptureMatcher::StateCount() const
+{
+    return m_accepting.size() - 1;
+}
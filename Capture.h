@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Automaton.h"
+#include <array>
+#include <string_view>
+#include <vector>
+
+namespace automaton
+{
+    struct Capture
+    {
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        std::size_t begin = npos;   //npos when the group took no part in the match
+        std::size_t end = npos;
+    };
+
+    //tagged DFA (Laurikari) for extracting the parenthesised groups of a whole-record match in one pass
+    //every parenthesis is a group, numbered by its opening parenthesis; | prefers its left side, * repeats as
+    //often as it can and a group keeps the last value it was given, like std::regex with ECMAScript syntax
+    //a DFA state is an ordered list of NFA threads together with the registers holding their tags, and the
+    //transitions carry the register copies and position stores that keep those registers up to date
+    class CaptureMatcher
+    {
+    public:
+        explicit CaptureMatcher(const std::string& regex);
+
+    public:
+        //groups[0] is the whole text and groups[k] the k-th group
+        bool Match(std::string_view text, std::vector<Capture>& groups) const;
+        std::size_t GroupCount() const;
+        std::size_t StateCount() const;
+
+    private:
+        static constexpr std::uint32_t storePosition = 0xFFFFFFFF;
+
+        struct Action
+        {
+            std::uint32_t target;
+            std::uint32_t source;   //register to copy, or storePosition
+        };
+
+        static void ApplyActions(const Action* first, const Action* last, bool copies, std::size_t position,
+                                 std::vector<std::size_t>& registers, std::vector<std::size_t>& scratch);
+
+    private:
+        std::array<std::uint8_t, 256> m_classes{};
+        std::size_t m_columns = 1;
+        std::size_t m_groups = 0;
+        std::size_t m_tags = 0;
+        std::size_t m_registers = 0;
+        state m_start = 0;
+        std::vector<state> m_next;                  //row 0 is the dead state
+        std::vector<std::uint32_t> m_actionBegin;   //actions of transition i are m_actions[m_actionBegin[i], m_actionBegin[i + 1])
+        std::vector<std::uint8_t> m_copies;         //whether transition i copies registers, not just stores positions
+        std::vector<Action> m_actions;
+        std::vector<Action> m_initialActions;
+        std::vector<std::uint8_t> m_accepting;
+        std::vector<std::uint32_t> m_acceptRegisters;   //registers of the tags when a state accepts, m_tags per state
+    };
+}
@@ -0,0 +1,116 @@
+#include "Capture.h"
+#include "Check.h"
+#include "RandomRegex.h"
+#include <regex>
+
+using namespace automaton;
+
+namespace
+{
+    struct RandomExpression
+    {
+        std::string regex;
+        bool nullable = false;
+        bool nullableLoop = false;  //a star over something that matches the empty word
+    };
+
+    //the regex together with what decides how closely it can be compared with std::regex
+    struct ExpressionBuilder
+    {
+        using Result = RandomExpression;
+
+        static RandomExpression Symbol(char symbol)
+        {
+            return {std::string(1, symbol)};
+        }
+
+        static RandomExpression Star(const RandomExpression& body)
+        {
+            return {test::RegexText::Star(body.regex), true, body.nullable || body.nullableLoop};
+        }
+
+        static RandomExpression Alternative(const RandomExpression& left, const RandomExpression& right)
+        {
+            return {test::RegexText::Alternative(left.regex, right.regex), left.nullable || right.nullable, left.nullableLoop || right.nullableLoop};
+        }
+
+        static RandomExpression Group(const RandomExpression& inner)
+        {
+            return {test::RegexText::Group(inner.regex), inner.nullable, inner.nullableLoop};
+        }
+
+        static RandomExpression Concat(const RandomExpression& left, const RandomExpression& right)
+        {
+            return {test::RegexText::Concat(left.regex, right.regex), left.nullable && right.nullable, left.nullableLoop || right.nullableLoop};
+        }
+    };
+
+    //the groups std::regex reports for a whole-record match, empty if there is none
+    std::vector<Capture> ReferenceGroups(const std::regex& reference, const std::string& text)
+    {
+        std::smatch match;
+        std::vector<Capture> groups;
+        if (!std::regex_match(text, match, reference))
+            return groups;
+        for (const auto& group : match) {
+            if (group.matched)
+                groups.push_back({static_cast<std::size_t>(group.first - text.begin()), static_cast<std::size_t>(group.second - text.begin())});
+            else groups.push_back({});
+        }
+        return groups;
+    }
+
+    //libstdc++ lets a loop over something nullable take one more empty iteration, which moves the groups inside
+    //it; there only the match itself has to agree
+    void CheckAgainstReference(const std::string& regex, const std::vector<std::string>& texts, bool onlyMatch = false)
+    {
+        CaptureMatcher tagged(regex);
+        std::regex reference(ParsingRegex(regex));
+        CHECK(tagged.GroupCount() == reference.mark_count());
+        std::vector<Capture> groups;
+        for (const auto& text : texts) {
+            auto expected = ReferenceGroups(reference, text);
+            if (!tagged.Match(text, groups))
+                groups.clear();
+            if (onlyMatch) {
+                groups.resize(std::min<std::size_t>(groups.size(), 1));
+                expected.resize(std::min<std::size_t>(expected.size(), 1));
+            }
+            bool same = std::equal(groups.begin(), groups.end(), expected.begin(), expected.end(), [](const Capture& first, const Capture& second) {
+                return first.begin == second.begin && first.end == second.end;
+            });
+            CHECK(same);
+            if (!same)
+                std::cerr << "  regex: " << regex << ", text: " << text << "\n";
+        }
+    }
+
+    void TestFixedExpressions()
+    {
+        std::vector<std::string> texts{"", "a", "ab", "aab", "abab", "abc", "aaa", "bab", "abcabc"};
+        for (const auto& regex : {"(a)", "(a*)", "(a|a.b)", "(a.b|a)*", "((a)|b)*", "(a*).(a*)", "((a.b)*).(c*)", "(a|b)*.(a.b)"}) {
+            CheckAgainstReference(regex, texts);
+        }
+        CheckAgainstReference("((a)*)*", texts, true);
+    }
+
+    void TestRandomExpressions()
+    {
+        std::mt19937 random(17);
+        for (int i = 0; i < 500; ++i) {
+            auto expression = test::RandomRegex<ExpressionBuilder>(random, 1 + i % 4, {.groups = true});
+            std::vector<std::string> texts;
+            for (int j = 0; j < 30; ++j) {
+                texts.push_back(test::RandomText(random, 6, 3));
+            }
+            CheckAgainstReference(expression.regex, texts, expression.nullableLoop);
+        }
+    }
+}
+
+int main()
+{
+    TestFixedExpressions();
+    TestRandomExpressions();
+    return test::Result();
+}
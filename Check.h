@@ -0,0 +1,24 @@
+#pragma once
+
+#include <iostream>
+
+//the tests are plain executables run by ctest: a failed check is reported and the test exits with 1
+namespace automaton::test
+{
+    inline int failures = 0;
+
+    inline int Result()
+    {
+        if (failures > 0)
+            std::cerr << failures << " checks failed\n";
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n";       \
+            automaton::test::failures += 1;                                                       \
+        }                                                                                         \
+    } while (false)
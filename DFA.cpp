@@ -1,5 +1,7 @@
 #include "DFA.h"
 #include <iomanip>
+#include <limits>
+#include <stdexcept>
 
 using namespace automaton;
 
@@ -72,47 +74,30 @@ bool DeterministicFiniteAutomaton::CheckWord(const std::string &word) {
             return false;
         }
     }
-    if (init != m_finalState) {
-        return false;
-    }
-    return true;
+    return m_finalStates.contains(init);
+}
+
+const std::unordered_set<state>& DeterministicFiniteAutomaton::GetFinalStates() const {
+    return m_finalStates;
 }
 
 std::unordered_set<state> DeterministicFiniteAutomaton::LambdaEncloseState(state q) const
 {
-    std::unordered_set<state> possibleStates;
-    std::unordered_set<state> visited;
-    possibleStates.insert(q);
-    visited.insert(q);
+    std::unordered_set<state> possibleStates{q};
     std::queue<state> statesToCheck;
     statesToCheck.push(q);
-    bool checked = false;
-
-    if (!m_deltaFunction.contains({q, lambda}))
-        return {};
 
     while (!statesToCheck.empty())
     {
-        for (const auto& [input, output] : m_deltaFunction)
-        {
-            if (input.first == q && std::holds_alternative<const char*>(input.second) && !checked)
-            {
-                checked = true;
-                for (auto elem : output) {
-                    statesToCheck.push(elem);
-                    possibleStates.insert(elem);
-                }
-            }
-            else if (possibleStates.contains(input.first) && !visited.contains(input.first) && std::holds_alternative<const char*>(input.second))
-            {
-                visited.insert(input.first);
-                for (auto elem : output) {
-                    statesToCheck.push(elem);
-                    possibleStates.insert(elem);
-                }
-            }
-        }
+        auto elem = statesToCheck.front();
         statesToCheck.pop();
+        auto lambdaTransition = m_deltaFunction.find({elem, lambda});
+        if (lambdaTransition == m_deltaFunction.end())
+            continue;
+        for (auto next : lambdaTransition->second) {
+            if (possibleStates.insert(next).second)
+                statesToCheck.push(next);
+        }
     }
 
     //TESTING OUTPUT
@@ -126,18 +111,10 @@ std::unordered_set<state> DeterministicFiniteAutomaton::LambdaEncloseState(state
 std::unordered_set<state> DeterministicFiniteAutomaton::PrimeLambdaEnclose(const std::unordered_set<state>& primeState) const
 {
     std::unordered_set<state> possibleStates;
-    std::queue<state> statesToCheck;
-
     for (auto elem : primeState) {
-        statesToCheck.push(elem);
-    }
-
-    while (!statesToCheck.empty()) {
-        auto elem = statesToCheck.front();
-        statesToCheck.pop();
+        if (possibleStates.contains(elem))
+            continue;
         auto stateSet = LambdaEncloseState(elem);
-        if (stateSet.size() == 0 && primeState.size() > 1)
-            possibleStates.insert(elem);
         possibleStates.insert(stateSet.begin(), stateSet.end());
     }
     return possibleStates;
@@ -155,49 +132,20 @@ std::unordered_set<state> DeterministicFiniteAutomaton::PrimeDeltaFunction(const
     return possibleStates;
 }
 
-void DeterministicFiniteAutomaton::GeneratePrimeTransitions()
-{
-    for (const auto& set : m_primeStates) {
-        for (char symbol : m_alphabet) {
-            std::set<state> possibleStates;
-            for (auto elem : set) {
-                std::unordered_set<state> possibleState;
-                try {
-                    possibleState = m_deltaFunction.at({elem, symbol});
-                } catch (std::out_of_range& e) {
-                    possibleState = {};
-                }
-                if (!possibleState.empty()) {
-                    possibleStates.insert(possibleState.begin(), possibleState.end());
-                }
-            }
-            if (!possibleStates.empty())
-                m_primeTransitions[{set, symbol}] = possibleStates;
-        }
-    }
-} //where can each set go with the respective symbol?
-
-void DeterministicFiniteAutomaton::OverrideAutomaton() {
+void DeterministicFiniteAutomaton::OverrideAutomaton(const std::set<state>& startPrimeState, state nfaFinalState) {
     m_deltaFunction.clear();
     m_states.clear();
-    bool changeInit = true;
-    bool changeFin = true;
+    m_finalStates.clear();
     for (const auto& [primeTrans, result]: m_primeTransitions) {
-        if (m_primeTransitions.contains(primeTrans))
-            m_deltaFunction[{m_primeStatesMapping[primeTrans.first], primeTrans.second}] = {m_primeStatesMapping[result]};
-        if (primeTrans.first.contains(m_initialState) && changeInit) {
-            m_initialState = m_primeStatesMapping[primeTrans.first];
-            changeInit = false;
-        }
-        if (primeTrans.first.contains(m_finalState) && changeFin) {
-            m_finalState = m_primeStatesMapping[primeTrans.first];
-            changeFin = false;
-        }
+        m_deltaFunction[{m_primeStatesMapping[primeTrans.first], primeTrans.second}] = {m_primeStatesMapping[result]};
     }
-    for (const auto& [input, output] : m_deltaFunction) {
-        m_states.insert(input.first);
-        m_states.insert(output.begin(), output.end());
+    for (const auto& [primeState, mapped] : m_primeStatesMapping) {
+        m_states.insert(mapped);
+        if (primeState.contains(nfaFinalState))
+            m_finalStates.insert(mapped);
     }
+    m_initialState = m_primeStatesMapping[startPrimeState];
+    m_finalState = m_finalStates.empty() ? m_initialState : *std::min_element(m_finalStates.begin(), m_finalStates.end());
 }
 
 
@@ -212,106 +160,56 @@ DeterministicFiniteAutomaton::DeterministicFiniteAutomaton(const automaton::Auto
     }
 
     if (!hasLambdaTransition) {
+        m_finalStates = {m_finalState};
         return;
     }
     //no lambda transitions means the automaton only has concatenation - already simplified by our standards! ty Cristi :3
 
-    std::queue<std::unordered_set<state> > toCheck;
-    toCheck.push({m_initialState});
+    //subset construction: every prime state is the lambda-closure of the states reached with a symbol
+    auto startPrimeState = UnorderedSetToSet<state>(PrimeLambdaEnclose({m_initialState}));
+    std::queue<std::set<state> > toCheck;
+    toCheck.push(startPrimeState);
+    m_primeStates.insert(startPrimeState);
 
     while (!toCheck.empty()) {
         auto stateSet = toCheck.front();
         toCheck.pop();
-        auto result = PrimeLambdaEnclose(stateSet);
-        if (stateSet.size() == 1 && result.size() == 0) //sets with no lambda transitions = state with only alphabet transitions, insert the states of the delta function result into m_primeStates
-        {
-            auto singleState = *stateSet.begin();
-            std::unordered_set<state> possibleStates;
-            for (char symbol : m_alphabet) {
-                if (m_deltaFunction.contains({singleState, symbol})) {
-                    possibleStates.insert(m_deltaFunction[{singleState, symbol}].begin(), m_deltaFunction[{singleState, symbol}].end());
-                    toCheck.push(possibleStates);
-                    m_primeStates.insert(UnorderedSetToSet<state>(stateSet));
-                }
-                else if (singleState == m_finalState) {
-                    m_primeStates.insert({singleState});
-                }
-            }
-        }
-        else if (!m_primeStates.contains(UnorderedSetToSet<state>(result)))
-        {
-            m_primeStates.insert(UnorderedSetToSet<state>(result));
-            for (char symbol : m_alphabet) {
-                std::unordered_set<state> transitionResult;
-                for (auto elem : result) {
-                    if (m_deltaFunction.contains({elem, symbol})) {
-                        transitionResult.insert(m_deltaFunction[{elem, symbol}].begin(), m_deltaFunction[{elem, symbol}].end());
-                    }
-                }
-                toCheck.push(transitionResult);
-            }
-        }
-    }
-    std::cout << "---------------------------------------------------\n";
-
-    for (const auto& elem : m_primeStates) {
-        for (auto val : elem) {
-            std::cout << val << " ";
+        for (char symbol : m_alphabet) {
+            auto result = PrimeLambdaEnclose(PrimeDeltaFunction(SetToUnorderedSet<state>(stateSet), symbol));
+            if (result.empty())
+                continue;
+            auto primeState = UnorderedSetToSet<state>(result);
+            m_primeTransitions[{stateSet, symbol}] = primeState;
+            if (!m_primeStates.insert(primeState).second)
+                continue;
+            //the prime states are numbered with state as well
+            if (m_primeStates.size() > std::numeric_limits<state>::max())
+                throw std::length_error("subset construction has too many states");
+            toCheck.push(primeState);
         }
-        std::cout << std::endl;
     }
-    std::cout << "---------------------------------------------------\n";
 
-    int counter = 0;
+    state counter = 0;
     for (const auto& elem : m_primeStates) {
         m_primeStatesMapping.insert({elem, counter});
         counter += 1;
     }
 
-    for (const auto& [x, y] : m_primeStatesMapping) {
-        for (auto elem : x) {
-            std::cout << elem << " ";
-        }
-        std::cout << ": " << y << std::endl;
-    }
-
-    std::cout << "---------------------------------------------------\n";
-
-    GeneratePrimeTransitions();
-
-    for (const auto& [pTransition, result] : m_primeTransitions) {
-        for (const auto& elem : pTransition.first) {
-            std::cout << elem << " ";
-        }
-        std::cout << "with " << pTransition.second << ": ";
-        for (const auto& elem: result) {
-            std::cout << elem << " ";
-        }
-        std::cout << std::endl;
-    }
-
-    for (auto& [pTransition, result] : m_primeTransitions) {
-        if (!m_primeStates.contains(result)) {
-            result = UnorderedSetToSet(PrimeLambdaEnclose(SetToUnorderedSet(result)));
-        }
-    }
-
-    std::cout << "---------------------------------------------------\n";
+    OverrideAutomaton(startPrimeState, automat.GetFinalState());
+}
 
-    for (const auto& [pTransition, result] : m_primeTransitions) {
-        for (const auto& elem : pTransition.first) {
-            std::cout << elem << " ";
-        }
-        std::cout << "with " << pTransition.second << ": ";
-        for (const auto& elem: result) {
-            std::cout << elem << " ";
-        }
-        std::cout << std::endl;
+DeterministicFiniteAutomaton::DeterministicFiniteAutomaton(state initialState, std::size_t stateCount, const std::unordered_set<char>& alphabet,
+                                                           const std::unordered_map<transition, std::unordered_set<state>, Hash>& deltaFunction,
+                                                           const std::unordered_set<state>& finalStates)
+    : Automaton{initialState, initialState}
+    , m_finalStates{finalStates}
+{
+    m_alphabet = alphabet;
+    m_deltaFunction = deltaFunction;
+    for (std::size_t elem = 0; elem < stateCount; ++elem) {
+        m_states.insert(static_cast<state>(elem));
     }
-
-    std::cout << "---------------------------------------------------\n";
-
-    OverrideAutomaton();
+    m_finalState = m_finalStates.empty() ? m_initialState : *std::min_element(m_finalStates.begin(), m_finalStates.end());
 }
 
 std::ostream& automaton::operator << (std::ostream& os, const DeterministicFiniteAutomaton& automaton) {
@@ -324,7 +222,10 @@ std::ostream& automaton::operator << (std::ostream& os, const DeterministicFinit
         os << "q" << s << " ";
     os << std::endl;
     os << "initial state: q" << automaton.GetStartState() << std::endl;
-    os << "final state: q" << automaton.GetFinalState() << std::endl;
+    os << "final states: ";
+    for (state s: automaton.GetFinalStates())
+        os << "q" << s << " ";
+    os << std::endl;
     os << "deltaFunction:\n";
     auto visitor = [](const auto &arg) -> std::string {
         using type = std::decay_t<decltype(arg)>;
@@ -35,15 +35,20 @@ namespace automaton
     {
     public:
         explicit DeterministicFiniteAutomaton(const automaton::Automaton& automat);
+        //states 0..stateCount-1 of a transition function that is already deterministic
+        DeterministicFiniteAutomaton(state initialState, std::size_t stateCount, const std::unordered_set<char>& alphabet,
+                                     const std::unordered_map<transition, std::unordered_set<state>, Hash>& deltaFunction,
+                                     const std::unordered_set<state>& finalStates);
         std::ostream& PrintAutomaton(std::ostream& os);
         bool CheckWord(const std::string& word);
+        const std::unordered_set<state>& GetFinalStates() const;
     private:
         std::unordered_set<state> LambdaEncloseState(state) const;
         std::unordered_set<state> PrimeLambdaEnclose(const std::unordered_set<state>& primeState) const;
         std::unordered_set<state> PrimeDeltaFunction(const std::unordered_set<state>& toCheck, char symbol);
-        void GeneratePrimeTransitions();
-        void OverrideAutomaton();
+        void OverrideAutomaton(const std::set<state>& startPrimeState, state nfaFinalState);
     private:
+        std::unordered_set<state> m_finalStates;
         std::unordered_set<std::set<state>, PrimeHash> m_primeStates;
         std::unordered_map<std::set<state>, state, PrimeHash> m_primeStatesMapping;
         std::unordered_map<primeTransition, std::set<state>, PrimeTransitionHash> m_primeTransitions;
@@ -0,0 +1,739 @@
+#include "Daemon.h"
+#include "PatternSet.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace automaton;
+
+namespace
+{
+    constexpr std::size_t headerSize = 4;
+    constexpr std::size_t maxFrameSize = std::size_t{64} << 20;
+
+    using Clock = std::chrono::steady_clock;
+
+    void AppendU32(std::string& buffer, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    //reads a u32 at offset, false if the buffer is too short
+    bool ReadU32(std::string_view buffer, std::size_t& offset, std::uint32_t& value)
+    {
+        if (buffer.size() < offset + 4)
+            return false;
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<std::uint32_t>(static_cast<unsigned char>(buffer[offset + i])) << (8 * i);
+        }
+        offset += 4;
+        return true;
+    }
+
+    std::string Frame(std::uint32_t requestId, Status status, const std::string& body)
+    {
+        std::string frame;
+        frame.reserve(headerSize + 5 + body.size());
+        AppendU32(frame, static_cast<std::uint32_t>(5 + body.size()));
+        AppendU32(frame, requestId);
+        frame.push_back(static_cast<char>(status));
+        frame.append(body);
+        return frame;
+    }
+
+    [[noreturn]] void ThrowSystemError(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    //only a socket that nobody accepts on anymore is removed, so a typo cannot delete a file and a second
+    //daemon cannot take over the socket of a running one; returns why the path cannot be used, or nothing
+    std::string ClaimSocketPath(const sockaddr_un& address)
+    {
+        struct stat status{};
+        if (lstat(address.sun_path, &status) < 0)
+            return errno == ENOENT ? std::string{} : std::strerror(errno);
+        if (!S_ISSOCK(status.st_mode))
+            return "exists and is not a socket";
+
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0)
+            return std::strerror(errno);
+        bool stale = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 && errno == ECONNREFUSED;
+        close(probe);
+        if (!stale)
+            return "another daemon is serving this socket";
+        if (unlink(address.sun_path) < 0)
+            return std::strerror(errno);
+        return {};
+    }
+
+    //log2 buckets of microseconds, bucket i holds latencies below 2^i us
+    class LatencyHistogram
+    {
+    public:
+        void Record(Clock::duration latency)
+        {
+            auto micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+            std::size_t bucket = std::min<std::size_t>(std::bit_width(micros), m_buckets.size() - 1);
+            m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_totalMicros.fetch_add(micros, std::memory_order_relaxed);
+        }
+
+        std::string Report(std::string_view name) const
+        {
+            std::uint64_t count = m_count.load();
+            if (count == 0)
+                return std::format("{}: no requests\n", name);
+            std::string report = std::format("{}: {} requests, mean {} us, p50 < {} us, p99 < {} us\n",
+                                             name,
+                                             count,
+                                             m_totalMicros.load() / count,
+                                             Percentile(count, 50),
+                                             Percentile(count, 99));
+            for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+                if (auto value = m_buckets[i].load())
+                    report += std::format("  < {:>10} us: {}\n", std::uint64_t{1} << i, value);
+            }
+            return report;
+        }
+
+    private:
+        std::uint64_t Percentile(std::uint64_t count, std::uint64_t percent) const
+        {
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+                seen += m_buckets[i].load();
+                if (seen * 100 >= count * percent)
+                    return std::uint64_t{1} << i;
+            }
+            return std::uint64_t{1} << (m_buckets.size() - 1);
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, 32> m_buckets{};
+        std::atomic<std::uint64_t> m_count = 0;
+        std::atomic<std::uint64_t> m_totalMicros = 0;
+    };
+
+    struct Job
+    {
+        std::uint64_t connection;
+        Opcode opcode;
+        std::uint32_t requestId;
+        std::string body;
+        Clock::time_point received;
+    };
+
+    struct Connection
+    {
+        int fd;
+        std::string in;
+        std::string out;
+        bool wantWrite = false;
+    };
+
+    class MatchDaemon
+    {
+    public:
+        explicit MatchDaemon(const DaemonOptions& options)
+            : m_options{options}
+        {
+        }
+
+        std::string Compile(const std::string& regex, std::uint32_t& patternId)
+        {
+            {
+                std::shared_lock lock(m_patternsMutex);
+                if (auto it = m_patternIds.find(regex); it != m_patternIds.end()) {
+                    patternId = it->second;
+                    return {};
+                }
+            }
+            if (!ValidateRegex(regex))
+                return "invalid regex " + regex;
+            std::shared_ptr<const Matcher> matcher;
+            try {
+                matcher = std::make_shared<const Matcher>(CompileRegex(regex, {Layout::BreadthFirst, {}, m_options.engine}));
+            }
+            catch (const std::exception& e) {
+                return e.what();
+            }
+            std::unique_lock lock(m_patternsMutex);
+            auto [it, inserted] = m_patternIds.try_emplace(regex, static_cast<std::uint32_t>(m_matchers.size()));
+            if (inserted)
+                m_matchers.push_back(std::move(matcher));
+            patternId = it->second;
+            return {};
+        }
+
+        int Run(const std::string& socketPath);
+
+    private:
+        void Work();
+        void Process(Job& job);
+        void Accept(int listener, int epoll);
+        bool ReadFrames(std::uint64_t id, Connection& connection);
+        bool Flush(int epoll, std::uint64_t id, Connection& connection);
+        void DrainCompletions(int epoll);
+        std::string Report() const;
+
+    private:
+        DaemonOptions m_options;
+
+        mutable std::shared_mutex m_patternsMutex;
+        std::unordered_map<std::string, std::uint32_t> m_patternIds;
+        std::vector<std::shared_ptr<const Matcher>> m_matchers;
+        PatternSet m_rules;
+
+        std::mutex m_jobsMutex;
+        std::condition_variable m_jobsReady;
+        std::deque<Job> m_jobs;
+        bool m_stopping = false;
+
+        std::mutex m_completionsMutex;
+        std::vector<std::pair<std::uint64_t, std::string>> m_completions;
+        int m_eventFd = -1;
+
+        std::unordered_map<std::uint64_t, Connection> m_connections;
+        std::uint64_t m_nextConnection = 3;
+
+        std::array<LatencyHistogram, 6> m_latencies;
+    };
+
+    //epoll ids below 3 are reserved for the listener, the completion eventfd and the signalfd
+    constexpr std::uint64_t listenerId = 0;
+    constexpr std::uint64_t completionsId = 1;
+    constexpr std::uint64_t signalsId = 2;
+
+    std::string MatchDaemon::Report() const
+    {
+        return m_latencies[static_cast<std::size_t>(Opcode::Compile)].Report("compile")
+               + m_latencies[static_cast<std::size_t>(Opcode::Match)].Report("match")
+               + m_latencies[static_cast<std::size_t>(Opcode::Stats)].Report("stats")
+               + m_latencies[static_cast<std::size_t>(Opcode::AddRule)].Report("add rule")
+               + m_latencies[static_cast<std::size_t>(Opcode::RemoveRule)].Report("remove rule");
+    }
+
+    void MatchDaemon::Process(Job& job)
+    {
+        Status status = Status::Ok;
+        std::string body;
+
+        //a request that fails only fails its own response, the other clients keep their daemon
+        try {
+            switch (job.opcode) {
+                case Opcode::Compile: {
+                    std::uint32_t patternId = 0;
+                    body = Compile(job.body, patternId);
+                    if (!body.empty())
+                        status = Status::Error;
+                    else
+                        AppendU32(body, patternId);
+                    break;
+                }
+                case Opcode::Match: {
+                    std::size_t offset = 0;
+                    std::uint32_t patternId;
+                    std::uint32_t count;
+                    bool valid = ReadU32(job.body, offset, patternId) && offset < job.body.size();
+                    std::uint8_t flags = valid ? static_cast<std::uint8_t>(job.body[offset++]) : 0;
+                    valid = valid && ReadU32(job.body, offset, count);
+
+                    std::shared_ptr<const Matcher> matcher;
+                    std::shared_ptr<const PatternSnapshot> rules;
+                    bool ruleSet = valid && patternId == ruleSetPatternId;
+                    if (ruleSet) {
+                        rules = m_rules.Snapshot();
+                    }
+                    else if (valid) {
+                        std::shared_lock lock(m_patternsMutex);
+                        if (patternId < m_matchers.size())
+                            matcher = m_matchers[patternId];
+                    }
+                    if (!matcher && !ruleSet) {
+                        status = Status::Error;
+                        body = valid ? "unknown pattern id" : "malformed match request";
+                        break;
+                    }
+
+                    AppendU32(body, count);
+                    for (std::uint32_t i = 0; i < count; ++i) {
+                        std::uint32_t length;
+                        if (!ReadU32(job.body, offset, length) || job.body.size() - offset < length) {
+                            status = Status::Error;
+                            body = "malformed match request";
+                            break;
+                        }
+                        std::string_view record(job.body.data() + offset, length);
+                        offset += length;
+                        //an empty rule set matches nothing
+                        bool whole = flags & matchWholeRecord;
+                        bool matched = ruleSet ? rules && (whole ? rules->Match(record) : rules->Search(record))
+                                               : (whole ? matcher->Match(record) : matcher->Search(record));
+                        body.push_back(static_cast<char>(matched));
+                    }
+                    break;
+                }
+                case Opcode::Stats: {
+                    body = Report();
+                    break;
+                }
+                case Opcode::AddRule: {
+                    AppendU32(body, static_cast<std::uint32_t>(m_rules.Add(job.body, m_options.engine)));
+                    break;
+                }
+                case Opcode::RemoveRule: {
+                    std::size_t offset = 0;
+                    std::uint32_t ruleId;
+                    if (!ReadU32(job.body, offset, ruleId) || !m_rules.Remove(ruleId)) {
+                        status = Status::Error;
+                        body = "unknown rule id";
+                    }
+                    break;
+                }
+                default: {
+                    status = Status::Error;
+                    body = "unknown opcode";
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            status = Status::Error;
+            body = e.what();
+        }
+        catch (...) {
+            status = Status::Error;
+            body = "internal error";
+        }
+
+        auto frame = Frame(job.requestId, status, body);
+        if (static_cast<std::size_t>(job.opcode) < m_latencies.size())
+            m_latencies[static_cast<std::size_t>(job.opcode)].Record(Clock::now() - job.received);
+        {
+            std::lock_guard lock(m_completionsMutex);
+            m_completions.emplace_back(job.connection, std::move(frame));
+        }
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto written = write(m_eventFd, &one, sizeof(one));
+    }
+
+    void MatchDaemon::Work()
+    {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock lock(m_jobsMutex);
+                m_jobsReady.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                if (m_jobs.empty())
+                    return;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            Process(job);
+        }
+    }
+
+    void MatchDaemon::Accept(int listener, int epoll)
+    {
+        while (true) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            std::uint64_t id = m_nextConnection++;
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+            m_connections.emplace(id, Connection{fd, {}, {}});
+        }
+    }
+
+    //reads what is available and queues every complete frame, false when the connection has to be closed
+    bool MatchDaemon::ReadFrames(std::uint64_t id, Connection& connection)
+    {
+        char block[1 << 16];
+        while (true) {
+            auto received = recv(connection.fd, block, sizeof(block), 0);
+            if (received == 0)
+                return false;
+            if (received < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return false;
+            }
+            connection.in.append(block, received);
+        }
+
+        auto now = Clock::now();
+        std::vector<Job> batch;
+        std::size_t offset = 0;
+        while (true) {
+            std::size_t frameStart = offset;
+            std::uint32_t length;
+            if (!ReadU32(connection.in, offset, length)) {
+                offset = frameStart;
+                break;
+            }
+            if (length < 5 || length > maxFrameSize)
+                return false;
+            if (connection.in.size() - offset < length) {
+                offset = frameStart;
+                break;
+            }
+            Job job;
+            job.connection = id;
+            job.opcode = static_cast<Opcode>(connection.in[offset]);
+            offset += 1;
+            ReadU32(connection.in, offset, job.requestId);
+            job.body.assign(connection.in, offset, length - 5);
+            job.received = now;
+            offset += length - 5;
+            batch.push_back(std::move(job));
+        }
+        connection.in.erase(0, offset);
+
+        if (!batch.empty()) {
+            {
+                std::lock_guard lock(m_jobsMutex);
+                for (auto& job : batch) {
+                    m_jobs.push_back(std::move(job));
+                }
+            }
+            if (batch.size() == 1)
+                m_jobsReady.notify_one();
+            else
+                m_jobsReady.notify_all();
+        }
+        return true;
+    }
+
+    bool MatchDaemon::Flush(int epoll, std::uint64_t id, Connection& connection)
+    {
+        std::size_t sent = 0;
+        while (sent < connection.out.size()) {
+            auto result = send(connection.fd, connection.out.data() + sent, connection.out.size() - sent, MSG_NOSIGNAL);
+            if (result < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return false;
+            }
+            sent += result;
+        }
+        connection.out.erase(0, sent);
+
+        bool wantWrite = !connection.out.empty();
+        if (wantWrite != connection.wantWrite) {
+            epoll_event event{};
+            event.events = wantWrite ? EPOLLIN | EPOLLOUT : static_cast<std::uint32_t>(EPOLLIN);
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.wantWrite = wantWrite;
+        }
+        return true;
+    }
+
+    void MatchDaemon::DrainCompletions(int epoll)
+    {
+        std::uint64_t counter;
+        [[maybe_unused]] auto drained = read(m_eventFd, &counter, sizeof(counter));
+
+        std::vector<std::pair<std::uint64_t, std::string>> completions;
+        {
+            std::lock_guard lock(m_completionsMutex);
+            completions.swap(m_completions);
+        }
+
+        std::vector<std::uint64_t> touched;
+        for (auto& [id, frame] : completions) {
+            auto it = m_connections.find(id);
+            if (it == m_connections.end())
+                continue;
+            if (it->second.out.empty())
+                touched.push_back(id);
+            it->second.out.append(frame);
+        }
+        for (auto id : touched) {
+            auto it = m_connections.find(id);
+            if (!Flush(epoll, id, it->second)) {
+                close(it->second.fd);
+                m_connections.erase(it);
+            }
+        }
+    }
+
+    int MatchDaemon::Run(const std::string& socketPath)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "socket path too long: " << socketPath << std::endl;
+            return 2;
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        if (auto error = ClaimSocketPath(address); !error.empty()) {
+            std::cerr << socketPath << ": " << error << std::endl;
+            return 2;
+        }
+        int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0
+            || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+            || listen(listener, SOMAXCONN) < 0) {
+            std::perror(socketPath.c_str());
+            return 2;
+        }
+
+        //signals are taken through a signalfd, so they are blocked before the workers inherit the mask
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        sigprocmask(SIG_BLOCK, &signals, nullptr);
+        int signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        int epoll = epoll_create1(EPOLL_CLOEXEC);
+
+        for (auto [fd, id] : {std::pair{listener, listenerId}, {m_eventFd, completionsId}, {signalFd, signalsId}}) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+        }
+
+        unsigned workerCount = m_options.workers ? m_options.workers : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { Work(); });
+        }
+        std::cerr << std::format("serving {} patterns on {} with {} workers\n", m_matchers.size(), socketPath, workerCount);
+
+        std::array<epoll_event, 64> events;
+        bool running = true;
+        while (running) {
+            int ready = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0 && errno != EINTR)
+                break;
+            for (int i = 0; i < ready; ++i) {
+                std::uint64_t id = events[i].data.u64;
+                if (id == listenerId) {
+                    Accept(listener, epoll);
+                    continue;
+                }
+                if (id == completionsId) {
+                    DrainCompletions(epoll);
+                    continue;
+                }
+                if (id == signalsId) {
+                    running = false;
+                    continue;
+                }
+
+                auto it = m_connections.find(id);
+                if (it == m_connections.end())
+                    continue;
+                bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+                if (alive && (events[i].events & EPOLLIN))
+                    alive = ReadFrames(id, it->second);
+                if (alive && (events[i].events & EPOLLOUT))
+                    alive = Flush(epoll, id, it->second);
+                if (!alive) {
+                    close(it->second.fd);
+                    m_connections.erase(it);
+                }
+            }
+        }
+
+        {
+            std::lock_guard lock(m_jobsMutex);
+            m_stopping = true;
+        }
+        m_jobsReady.notify_all();
+        workers.clear();
+
+        for (auto& [id, connection] : m_connections) {
+            close(connection.fd);
+        }
+        close(epoll);
+        close(m_eventFd);
+        close(signalFd);
+        close(listener);
+        unlink(socketPath.c_str());
+        std::cerr << Report();
+        return 0;
+    }
+}
+
+int automaton::RunDaemon(const std::string& socketPath, const std::vector<std::string>& patterns, const DaemonOptions& options)
+{
+    MatchDaemon daemon(options);
+    for (const auto& pattern : patterns) {
+        std::uint32_t patternId;
+        auto error = daemon.Compile(pattern, patternId);
+        if (!error.empty()) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+    }
+    return daemon.Run(socketPath);
+}
+
+MatchClient::MatchClient(const std::string& socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::invalid_argument("socket path too long: " + socketPath);
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0)
+        ThrowSystemError("socket");
+    if (connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(m_socket);
+        ThrowSystemError(socketPath.c_str());
+    }
+}
+
+MatchClient::~MatchClient()
+{
+    close(m_socket);
+}
+
+std::uint32_t MatchClient::Send(Opcode opcode, const std::string& body)
+{
+    if (5 + body.size() > maxFrameSize)
+        throw std::length_error("request is larger than the daemon accepts");
+    std::uint32_t requestId = m_nextRequest++;
+    std::string frame;
+    AppendU32(frame, static_cast<std::uint32_t>(5 + body.size()));
+    frame.push_back(static_cast<char>(opcode));
+    AppendU32(frame, requestId);
+    frame.append(body);
+
+    std::size_t sent = 0;
+    while (sent < frame.size()) {
+        auto result = send(m_socket, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            ThrowSystemError("send");
+        }
+        sent += result;
+    }
+    return requestId;
+}
+
+//responses for other requests read on the way are kept until they are asked for
+std::string MatchClient::Receive(std::uint32_t requestId)
+{
+    while (!m_pending.contains(requestId)) {
+        std::size_t offset = 0;
+        std::uint32_t length;
+        if (ReadU32(m_buffer, offset, length) && m_buffer.size() - offset >= length && length >= 5) {
+            std::uint32_t id = 0;
+            ReadU32(m_buffer, offset, id);
+            auto status = static_cast<Status>(m_buffer[offset]);
+            offset += 1;
+            m_pending[id] = {status, m_buffer.substr(offset, length - 5)};
+            m_buffer.erase(0, offset + length - 5);
+            continue;
+        }
+
+        char block[1 << 16];
+        auto received = recv(m_socket, block, sizeof(block), 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0)
+            ThrowSystemError("recv");
+        if (received == 0)
+            throw std::runtime_error("daemon closed the connection");
+        m_buffer.append(block, received);
+    }
+
+    auto node = m_pending.extract(requestId);
+    auto& [status, body] = node.mapped();
+    if (status != Status::Ok)
+        throw std::runtime_error(body);
+    return std::move(body);
+}
+
+std::uint32_t MatchClient::Compile(const std::string& regex)
+{
+    auto body = Receive(Send(Opcode::Compile, regex));
+    std::size_t offset = 0;
+    std::uint32_t patternId = 0;
+    ReadU32(body, offset, patternId);
+    return patternId;
+}
+
+std::string MatchClient::Stats()
+{
+    return Receive(Send(Opcode::Stats, {}));
+}
+
+std::uint32_t MatchClient::AddRule(const std::string& regex)
+{
+    auto body = Receive(Send(Opcode::AddRule, regex));
+    std::size_t offset = 0;
+    std::uint32_t ruleId = 0;
+    ReadU32(body, offset, ruleId);
+    return ruleId;
+}
+
+void MatchClient::RemoveRule(std::uint32_t ruleId)
+{
+    std::string body;
+    AppendU32(body, ruleId);
+    Receive(Send(Opcode::RemoveRule, body));
+}
+
+std::uint32_t MatchClient::SendMatch(std::uint32_t patternId, bool wholeRecord, const std::vector<std::string_view>& records)
+{
+    std::string body;
+    AppendU32(body, patternId);
+    body.push_back(static_cast<char>(wholeRecord ? matchWholeRecord : 0));
+    AppendU32(body, static_cast<std::uint32_t>(records.size()));
+    for (auto record : records) {
+        AppendU32(body, static_cast<std::uint32_t>(record.size()));
+        body.append(record);
+    }
+    return Send(Opcode::Match, body);
+}
+
+std::vector<bool> MatchClient::ReceiveMatch(std::uint32_t requestId)
+{
+    auto body = Receive(requestId);
+    std::size_t offset = 0;
+    std::uint32_t count = 0;
+    ReadU32(body, offset, count);
+    std::vector<bool> results(count);
+    for (std::uint32_t i = 0; i < count && offset + i < body.size(); ++i) {
+        results[i] = body[offset + i] != 0;
+    }
+    return results;
+}
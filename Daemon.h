@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Matcher.h"
+#include <map>
+#include <string>
+#include <vector>
+
+//wire format, all integers are little-endian u32 unless noted otherwise
+//request:  length | opcode (u8) | request id | body        (length counts everything after itself)
+//response: length | request id | status (u8) | body
+//  Compile  body: regex                                      -> pattern id
+//  Match    body: pattern id | flags (u8) | count | count x (length | record) -> count | count x result (u8)
+//  Stats    body: -                                          -> latency report as text
+//  AddRule  body: regex                                      -> rule id
+//  RemoveRule body: rule id                                  -> -
+//requests can be pipelined, responses carry the request id and may come back out of order
+//Match requests for ruleSetPatternId run against the live rule set; rules are added and removed
+//without blocking matches, which keep using the previous version until the new one is swapped in
+
+namespace automaton
+{
+    enum class Opcode : std::uint8_t
+    {
+        Compile = 1,
+        Match = 2,
+        Stats = 3,
+        AddRule = 4,
+        RemoveRule = 5
+    };
+
+    enum class Status : std::uint8_t
+    {
+        Ok = 0,
+        Error = 1
+    };
+
+    inline constexpr std::uint8_t matchWholeRecord = 1;
+    inline constexpr std::uint32_t ruleSetPatternId = 0xFFFFFFFF;
+
+    struct DaemonOptions
+    {
+        unsigned workers = 0;   //0 means one per hardware thread
+        Engine engine = Engine::Thompson;   //used for every pattern and rule the daemon compiles
+    };
+
+    //serves the patterns (and everything compiled later through Compile requests) until SIGINT/SIGTERM
+    int RunDaemon(const std::string& socketPath, const std::vector<std::string>& patterns, const DaemonOptions& options);
+
+    class MatchClient
+    {
+    public:
+        explicit MatchClient(const std::string& socketPath);
+        MatchClient(const MatchClient&) = delete;
+        MatchClient& operator = (const MatchClient&) = delete;
+        ~MatchClient();
+
+    public:
+        std::uint32_t Compile(const std::string& regex);
+        std::string Stats();
+        std::uint32_t AddRule(const std::string& regex);
+        void RemoveRule(std::uint32_t ruleId);
+        std::uint32_t SendMatch(std::uint32_t patternId, bool wholeRecord, const std::vector<std::string_view>& records);
+        std::vector<bool> ReceiveMatch(std::uint32_t requestId);
+
+    private:
+        std::uint32_t Send(Opcode opcode, const std::string& body);
+        std::string Receive(std::uint32_t requestId);
+
+    private:
+        int m_socket;
+        std::uint32_t m_nextRequest = 0;
+        std::string m_buffer;
+        std::map<std::uint32_t, std::pair<Status, std::string>> m_pending;
+    };
+}
@@ -0,0 +1,151 @@
+#include "Check.h"
+#include "Daemon.h"
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace automaton;
+
+namespace
+{
+    //a daemon in a child process, stopped with SIGTERM like from the command line
+    class DaemonProcess
+    {
+    public:
+        DaemonProcess(const std::string& socketPath, const std::vector<std::string>& patterns)
+            : m_pid{fork()}
+        {
+            if (m_pid == 0)
+                _exit(RunDaemon(socketPath, patterns, DaemonOptions{2, Engine::Thompson}));
+        }
+
+        ~DaemonProcess()
+        {
+            Stop();
+        }
+
+        int Stop()
+        {
+            if (m_pid <= 0)
+                return m_status;
+            kill(m_pid, SIGTERM);
+            int status = 0;
+            waitpid(m_pid, &status, 0);
+            m_pid = -1;
+            m_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            return m_status;
+        }
+
+    private:
+        pid_t m_pid;
+        int m_status = -1;
+    };
+
+    //the daemon needs a moment to bind its socket
+    std::unique_ptr<MatchClient> Connect(const std::string& socketPath)
+    {
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            try {
+                return std::make_unique<MatchClient>(socketPath);
+            }
+            catch (const std::exception&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename Request>
+    bool Fails(Request request)
+    {
+        try {
+            request();
+        }
+        catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    void TestRoundTrip(const std::string& socketPath)
+    {
+        DaemonProcess daemon(socketPath, {"a.b*"});
+        auto client = Connect(socketPath);
+        CHECK(client != nullptr);
+        if (!client)
+            return;
+
+        //patterns given on the command line come first and the same regex always gets the same id
+        CHECK(client->Compile("a.b*") == 0);
+        auto second = client->Compile("(x|y)*.z");
+        CHECK(second == 1);
+        CHECK(client->Compile("(x|y)*.z") == second);
+
+        //pipelined batches, collected out of order
+        std::vector<std::string_view> records{"abbb", "ba", "xyxz", "", "zz"};
+        auto searchFirst = client->SendMatch(0, false, records);
+        auto wholeFirst = client->SendMatch(0, true, records);
+        auto searchSecond = client->SendMatch(second, false, records);
+        CHECK((client->ReceiveMatch(searchSecond) == std::vector<bool>{false, false, true, false, true}));
+        CHECK((client->ReceiveMatch(wholeFirst) == std::vector<bool>{true, false, false, false, false}));
+        CHECK((client->ReceiveMatch(searchFirst) == std::vector<bool>{true, true, false, false, false}));
+
+        //failed requests only fail themselves
+        CHECK(Fails([&] { client->Compile("a|"); }));
+        CHECK(Fails([&] { client->ReceiveMatch(client->SendMatch(42, false, records)); }));
+        CHECK(client->Compile("a.b*") == 0);
+
+        //the rule set starts empty and follows every add and remove
+        CHECK((client->ReceiveMatch(client->SendMatch(ruleSetPatternId, false, records)) == std::vector<bool>(5, false)));
+        auto first = client->AddRule("a.b");
+        auto other = client->AddRule("z");
+        CHECK(first != other);
+        CHECK((client->ReceiveMatch(client->SendMatch(ruleSetPatternId, false, records)) == std::vector<bool>{true, false, true, false, true}));
+        client->RemoveRule(other);
+        CHECK((client->ReceiveMatch(client->SendMatch(ruleSetPatternId, true, records)) == std::vector<bool>{false, false, false, false, false}));
+        CHECK((client->ReceiveMatch(client->SendMatch(ruleSetPatternId, false, records)) == std::vector<bool>{true, false, false, false, false}));
+        CHECK(Fails([&] { client->RemoveRule(other); }));
+        CHECK(Fails([&] { client->AddRule("(a"); }));
+
+        CHECK(client->Stats().find("add rule: 3 requests") != std::string::npos);
+        client.reset();
+        CHECK(daemon.Stop() == 0);
+        CHECK(access(socketPath.c_str(), F_OK) != 0);
+    }
+
+    void TestSocketPath(const std::string& socketPath)
+    {
+        //a file that is not a socket is left alone
+        {
+            std::ofstream file(socketPath);
+            file << "keep";
+        }
+        CHECK(RunDaemon(socketPath, {}, {}) == 2);
+        std::ifstream file(socketPath);
+        std::string content;
+        file >> content;
+        CHECK(content == "keep");
+        unlink(socketPath.c_str());
+
+        //a live daemon keeps its socket
+        DaemonProcess daemon(socketPath, {});
+        auto client = Connect(socketPath);
+        CHECK(client != nullptr);
+        CHECK(RunDaemon(socketPath, {}, {}) == 2);
+        if (client)
+            CHECK(client->Compile("a") == 0);
+    }
+}
+
+int main()
+{
+    std::string socketPath = "/tmp/automaton-test-" + std::to_string(getpid()) + ".sock";
+    TestRoundTrip(socketPath);
+    TestSocketPath(socketPath);
+    unlink(socketPath.c_str());
+    return test::Result();
+}
@@ -0,0 +1,264 @@
+#include "Derivative.h"
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+using namespace automaton;
+
+namespace
+{
+    enum class Kind : std::uint8_t
+    {
+        Empty,      //matches nothing
+        Epsilon,    //matches the empty word
+        Symbol,
+        Concat,
+        Union,
+        Star
+    };
+
+    struct Term
+    {
+        Kind kind;
+        char symbol;
+        std::uint32_t left;
+        std::uint32_t right;
+        bool nullable;
+    };
+
+    struct TermHash
+    {
+        std::size_t operator () (const std::tuple<Kind, char, std::uint32_t, std::uint32_t>& key) const
+        {
+            auto [kind, symbol, left, right] = key;
+            std::size_t seed = static_cast<std::size_t>(kind) | (static_cast<std::size_t>(static_cast<unsigned char>(symbol)) << 8);
+            seed ^= std::hash<std::uint32_t>()(left) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<std::uint32_t>()(right) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    //hash-consed regex terms, equal terms share an id so derivatives can be compared by id
+    //unions are kept as right-nested chains of non-union terms sorted by id and without duplicates,
+    //concatenations are right-nested
+    class RegexTerms
+    {
+    public:
+        static constexpr std::uint32_t empty = 0;
+        static constexpr std::uint32_t epsilon = 1;
+
+        RegexTerms()
+        {
+            Intern(Kind::Empty, 0, 0, 0, false);
+            Intern(Kind::Epsilon, 0, 0, 0, true);
+        }
+
+        std::uint32_t MakeSymbol(char symbol)
+        {
+            return Intern(Kind::Symbol, symbol, 0, 0, false);
+        }
+
+        std::uint32_t MakeConcat(std::uint32_t left, std::uint32_t right)
+        {
+            if (left == empty || right == empty)
+                return empty;
+            if (left == epsilon)
+                return right;
+            if (right == epsilon)
+                return left;
+            if (m_terms[left].kind == Kind::Concat)
+                return MakeConcat(m_terms[left].left, MakeConcat(m_terms[left].right, right));
+            if (m_terms[left].kind == Kind::Union) {
+                //(r|s).t = r.t|s.t, so a derivative is the set of Antimirov partial derivatives
+                std::vector<std::uint32_t> alternatives;
+                Flatten(left, alternatives);
+                for (auto& alternative : alternatives) {
+                    alternative = MakeConcat(alternative, right);
+                }
+                return MakeUnion(std::move(alternatives));
+            }
+            return Intern(Kind::Concat, 0, left, right, m_terms[left].nullable && m_terms[right].nullable);
+        }
+
+        std::uint32_t MakeUnion(std::vector<std::uint32_t> operands)
+        {
+            std::vector<std::uint32_t> flat;
+            for (auto operand : operands) {
+                Flatten(operand, flat);
+            }
+            std::sort(flat.begin(), flat.end());
+            flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+            std::erase(flat, empty);
+            if (flat.empty())
+                return empty;
+            //epsilon adds nothing next to another nullable alternative
+            if (flat.size() > 1 && flat.front() == epsilon
+                && std::any_of(flat.begin() + 1, flat.end(), [&](std::uint32_t term) { return m_terms[term].nullable; }))
+                flat.erase(flat.begin());
+
+            auto result = flat.back();
+            for (auto it = flat.rbegin() + 1; it != flat.rend(); ++it) {
+                result = Intern(Kind::Union, 0, *it, result, m_terms[*it].nullable || m_terms[result].nullable);
+            }
+            return result;
+        }
+
+        std::uint32_t MakeStar(std::uint32_t operand)
+        {
+            if (operand == empty || operand == epsilon)
+                return epsilon;
+            if (m_terms[operand].kind == Kind::Star)
+                return operand;
+            if (m_terms[operand].kind == Kind::Union) {
+                //(epsilon|r)* = r* and (r*|s)* = (r|s)*
+                std::vector<std::uint32_t> alternatives;
+                Flatten(operand, alternatives);
+                std::erase(alternatives, epsilon);
+                for (auto& alternative : alternatives) {
+                    if (m_terms[alternative].kind == Kind::Star)
+                        alternative = m_terms[alternative].left;
+                }
+                auto simplified = MakeUnion(std::move(alternatives));
+                if (simplified != operand)
+                    return MakeStar(simplified);
+            }
+            return Intern(Kind::Star, 0, operand, 0, true);
+        }
+
+        bool IsNullable(std::uint32_t term) const
+        {
+            return m_terms[term].nullable;
+        }
+
+        std::uint32_t Derive(std::uint32_t term, char symbol)
+        {
+            //most alternatives of a word list start with a symbol and are derived without the memo table,
+            //whose lookups miss the cache once the list is long
+            const Term& head = m_terms[term];
+            if (head.kind == Kind::Symbol)
+                return head.symbol == symbol ? epsilon : empty;
+            if (head.kind == Kind::Concat && m_terms[head.left].kind == Kind::Symbol)
+                return m_terms[head.left].symbol == symbol ? head.right : empty;
+
+            std::uint64_t key = (static_cast<std::uint64_t>(term) << 8) | static_cast<unsigned char>(symbol);
+            if (auto it = m_derivatives.find(key); it != m_derivatives.end())
+                return it->second;
+
+            const Term current = m_terms[term];
+            std::uint32_t result = empty;
+            switch (current.kind) {
+                case Kind::Empty:
+                case Kind::Epsilon:
+                    break;
+                case Kind::Symbol:
+                    result = current.symbol == symbol ? epsilon : empty;
+                    break;
+                case Kind::Concat: {
+                    auto head = MakeConcat(Derive(current.left, symbol), current.right);
+                    result = m_terms[current.left].nullable ? MakeUnion({head, Derive(current.right, symbol)}) : head;
+                    break;
+                }
+                case Kind::Union: {
+                    //walk the chain instead of recursing, alternations can be long
+                    std::vector<std::uint32_t> alternatives;
+                    Flatten(term, alternatives);
+                    for (auto& alternative : alternatives) {
+                        alternative = Derive(alternative, symbol);
+                    }
+                    result = MakeUnion(std::move(alternatives));
+                    break;
+                }
+                case Kind::Star:
+                    result = MakeConcat(Derive(current.left, symbol), term);
+                    break;
+            }
+            m_derivatives.emplace(key, result);
+            return result;
+        }
+
+    private:
+        std::uint32_t Intern(Kind kind, char symbol, std::uint32_t left, std::uint32_t right, bool nullable)
+        {
+            auto [it, inserted] = m_ids.try_emplace({kind, symbol, left, right}, static_cast<std::uint32_t>(m_terms.size()));
+            if (inserted)
+                m_terms.push_back({kind, symbol, left, right, nullable});
+            return it->second;
+        }
+
+        void Flatten(std::uint32_t term, std::vector<std::uint32_t>& output) const
+        {
+            while (m_terms[term].kind == Kind::Union) {
+                output.push_back(m_terms[term].left);
+                term = m_terms[term].right;
+            }
+            output.push_back(term);
+        }
+
+    private:
+        std::vector<Term> m_terms;
+        std::unordered_map<std::tuple<Kind, char, std::uint32_t, std::uint32_t>, std::uint32_t, TermHash> m_ids;
+        std::unordered_map<std::uint64_t, std::uint32_t> m_derivatives;
+    };
+}
+
+DeterministicFiniteAutomaton automaton::BuildDerivativeAutomaton(const std::string& regex)
+{
+    RegexTerms terms;
+    //every operand is a list of alternatives and a run of | only joins lists; interning each binary | of the
+    //left-nested postfix form would build a new chain of unions for every alternative added
+    std::stack<std::vector<std::uint32_t>> operands;
+    auto pop = [&] {
+        auto alternatives = std::move(operands.top());
+        operands.pop();
+        return alternatives.size() == 1 ? alternatives.front() : terms.MakeUnion(std::move(alternatives));
+    };
+    std::unordered_set<char> alphabet;
+
+    for (char character : RegexToPolishForm(regex)) {
+        if (IsSymbol(character)) {
+            operands.push({terms.MakeSymbol(character)});
+            alphabet.insert(character);
+            continue;
+        }
+        if (character == '|') {
+            auto right = std::move(operands.top());
+            operands.pop();
+            operands.top().insert(operands.top().end(), right.begin(), right.end());
+            continue;
+        }
+        auto right = pop();
+        if (character == '*') {
+            operands.push({terms.MakeStar(right)});
+            continue;
+        }
+        auto left = pop();
+        operands.push({terms.MakeConcat(left, right)});
+    }
+    auto root = pop();
+
+    //breadth-first over the derivatives, the empty language is the dead state and gets no row
+    std::unordered_map<std::uint32_t, state> states;
+    std::vector<std::uint32_t> order{root};
+    states.emplace(root, 0);
+    std::unordered_map<transition, std::unordered_set<state>, Hash> deltaFunction;
+    std::unordered_set<state> finalStates;
+
+    for (std::size_t current = 0; current < order.size(); ++current) {
+        if (terms.IsNullable(order[current]))
+            finalStates.insert(static_cast<state>(current));
+        for (char symbol : alphabet) {
+            auto derivative = terms.Derive(order[current], symbol);
+            if (derivative == RegexTerms::empty)
+                continue;
+            auto [it, inserted] = states.try_emplace(derivative, static_cast<state>(order.size()));
+            if (inserted) {
+                if (order.size() >= std::numeric_limits<state>::max())
+                    throw std::length_error("derivative automaton has too many states");
+                order.push_back(derivative);
+            }
+            deltaFunction[{static_cast<state>(current), symbol}] = {it->second};
+        }
+    }
+
+    return DeterministicFiniteAutomaton{0, order.size(), alphabet, deltaFunction, finalStates};
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "DFA.h"
+
+namespace automaton
+{
+    //Brzozowski construction: every DFA state is a distinct derivative of the regex, so there is no NFA and no
+    //lambda-closure; derivatives are kept in a normal form (| is associative, commutative and idempotent)
+    //which keeps their number finite and usually close to the minimal DFA
+    DeterministicFiniteAutomaton BuildDerivativeAutomaton(const std::string& regex);
+}
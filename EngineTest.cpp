@@ -0,0 +1,105 @@
+#include "Check.h"
+#include "RandomRegex.h"
+#include "Equivalence.h"
+#include "Derivative.h"
+#include "Glushkov.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace automaton;
+
+namespace
+{
+    //repeated subterms next to the nested stars, the cases derivatives need their similarity rules for
+    constexpr test::RegexShape shape{.repeats = true};
+
+    Matcher Compile(const std::string& regex, Engine engine)
+    {
+        return CompileRegex(regex, {Layout::Original, {}, engine, false});
+    }
+
+    //every engine has to build an automaton for the language of the Thompson construction
+    void CheckEngine(Engine engine, const std::string& regex)
+    {
+        CHECK(ValidateRegex(regex));
+        bool equivalent = AreEquivalent(Compile(regex, Engine::Thompson), Compile(regex, engine));
+        CHECK(equivalent);
+        if (!equivalent)
+            std::cerr << "  regex: " << regex << "\n";
+    }
+
+    void TestFixedExpressions(Engine engine)
+    {
+        for (const auto& regex : {"a", "a*", "(a*)*", "(a|b)*.a.(a|b)", "(a*.b*)*", "(a.b|a)*.(b|a.a)", "((a|b)*.c)*",
+                                  "a.b.c|a.b.d|a.c", "(a|a.a)*.(a.a.a)*"}) {
+            CheckEngine(engine, regex);
+        }
+    }
+
+    void TestRandomExpressions(Engine engine)
+    {
+        std::mt19937 random(11);
+        for (int i = 0; i < 1000; ++i) {
+            CheckEngine(engine, test::RandomRegex(random, 1 + i % 5, shape));
+        }
+    }
+
+    //one state per symbol plus the start state, and no lambda-edges
+    void TestPositionAutomaton()
+    {
+        std::mt19937 random(13);
+        for (int i = 0; i < 200; ++i) {
+            auto regex = test::RandomRegex(random, 1 + i % 5, shape);
+            auto symbols = std::count_if(regex.begin(), regex.end(), IsSymbol);
+            PositionAutomaton automat(regex);
+            CHECK(automat.GetStates().size() == static_cast<std::size_t>(symbols) + 1);
+            for (const auto& [input, output] : automat.GetDeltaFunction()) {
+                CHECK(std::holds_alternative<char>(input.second));
+            }
+        }
+    }
+
+    //fastest of three builds, so a loaded machine does not make the ratio below flaky
+    double DerivativeBuildSeconds(std::size_t words)
+    {
+        std::mt19937 random(19);
+        std::vector<std::string> patterns(words);
+        for (auto& pattern : patterns) {
+            for (std::size_t length = 4 + random() % 6; length > 0; --length) {
+                pattern += pattern.empty() ? "" : ".";
+                pattern += static_cast<char>('a' + random() % 26);
+            }
+        }
+        auto regex = JoinAlternatives(patterns);
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            BuildDerivativeAutomaton(regex);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    //a long alternation has to be interned once, not once per |: four times the words may take about four
+    //times as long, where interning every | took sixteen
+    void TestDerivativeScaling()
+    {
+        double small = DerivativeBuildSeconds(1000);
+        double large = DerivativeBuildSeconds(4000);
+        CHECK(large < 10 * small);
+        if (large >= 10 * small)
+            std::cerr << "  1000 words: " << small << " s, 4000 words: " << large << " s\n";
+    }
+}
+
+int main()
+{
+    TestFixedExpressions(Engine::Derivative);
+    TestRandomExpressions(Engine::Derivative);
+    TestFixedExpressions(Engine::Glushkov);
+    TestRandomExpressions(Engine::Glushkov);
+    TestPositionAutomaton();
+    TestDerivativeScaling();
+    return test::Result();
+}
@@ -0,0 +1,234 @@
+#include "Equivalence.h"
+#include <map>
+#include <numeric>
+#include <optional>
+#include <unordered_set>
+
+using namespace automaton;
+
+namespace
+{
+    class DisjointSets
+    {
+    public:
+        explicit DisjointSets(std::size_t size)
+            : m_parent(size)
+            , m_rank(size, 0)
+        {
+            std::iota(m_parent.begin(), m_parent.end(), 0);
+        }
+
+        std::size_t Find(std::size_t element)
+        {
+            while (m_parent[element] != element) {
+                m_parent[element] = m_parent[m_parent[element]];
+                element = m_parent[element];
+            }
+            return element;
+        }
+
+        //false if both were already in the same set
+        bool Unite(std::size_t first, std::size_t second)
+        {
+            first = Find(first);
+            second = Find(second);
+            if (first == second)
+                return false;
+            if (m_rank[first] < m_rank[second])
+                std::swap(first, second);
+            m_parent[second] = first;
+            if (m_rank[first] == m_rank[second])
+                m_rank[first] += 1;
+            return true;
+        }
+
+    private:
+        std::vector<std::size_t> m_parent;
+        std::vector<std::uint8_t> m_rank;
+    };
+
+    //what the automata of equal languages agree on, whatever their states look like
+    struct LanguageProfile
+    {
+        std::string symbols;    //sorted bytes that occur in accepted words
+        std::string shortest;   //shortest accepted word, the smallest one of that length
+        bool empty = true;      //nothing is accepted
+    };
+
+    //breadth-first with the symbols in order reaches every state first along its shortlex-least word, and the
+    //symbols that matter are the ones on edges between states that can still reach an accepting state
+    LanguageProfile Profile(const Matcher& matcher)
+    {
+        auto symbols = matcher.GetSymbols();
+        std::size_t rows = matcher.StateCount() + 1;
+        std::vector<std::pair<row, unsigned char>> parent(rows);
+        std::vector<std::uint8_t> reached(rows, 0);
+        std::vector<row> order{matcher.GetStartState()};
+        std::vector<std::vector<row>> incoming(rows);
+        reached[0] = 1;
+        reached[matcher.GetStartState()] = 1;
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            for (auto symbol : symbols) {
+                row next = matcher.Step(order[i], symbol);
+                if (next == 0)
+                    continue;
+                incoming[next].push_back(order[i]);
+                if (reached[next])
+                    continue;
+                reached[next] = 1;
+                parent[next] = {order[i], symbol};
+                order.push_back(next);
+            }
+        }
+
+        LanguageProfile profile;
+        std::vector<std::uint8_t> live(rows, 0);
+        std::vector<row> toVisit;
+        for (auto current : order) {
+            if (!matcher.IsAccepting(current))
+                continue;
+            if (profile.empty) {
+                for (row walk = current; walk != matcher.GetStartState(); walk = parent[walk].first) {
+                    profile.shortest.push_back(static_cast<char>(parent[walk].second));
+                }
+                std::reverse(profile.shortest.begin(), profile.shortest.end());
+                profile.empty = false;
+            }
+            live[current] = 1;
+            toVisit.push_back(current);
+        }
+        while (!toVisit.empty()) {
+            auto current = toVisit.back();
+            toVisit.pop_back();
+            for (auto previous : incoming[current]) {
+                if (!live[previous]) {
+                    live[previous] = 1;
+                    toVisit.push_back(previous);
+                }
+            }
+        }
+
+        for (auto symbol : symbols) {
+            bool used = std::any_of(order.begin(), order.end(), [&](row current) {
+                return live[current] && live[matcher.Step(current, symbol)];
+            });
+            if (used)
+                profile.symbols.push_back(static_cast<char>(symbol));
+        }
+        return profile;
+    }
+
+    //bytes outside both alphabets lead both automata to their dead state, so they never tell them apart
+    std::vector<unsigned char> MergeSymbols(const Matcher& first, const Matcher& second)
+    {
+        auto symbols = first.GetSymbols();
+        auto others = second.GetSymbols();
+        symbols.insert(symbols.end(), others.begin(), others.end());
+        std::sort(symbols.begin(), symbols.end());
+        symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+        return symbols;
+    }
+}
+
+bool automaton::AreEquivalent(const Matcher& first, const Matcher& second)
+{
+    auto symbols = MergeSymbols(first, second);
+    std::size_t offset = first.StateCount() + 1;
+    DisjointSets sets(offset + second.StateCount() + 1);
+
+    std::vector<std::pair<row, row>> toCheck{{first.GetStartState(), second.GetStartState()}};
+    sets.Unite(first.GetStartState(), offset + second.GetStartState());
+    while (!toCheck.empty()) {
+        auto [p, q] = toCheck.back();
+        toCheck.pop_back();
+        if (first.IsAccepting(p) != second.IsAccepting(q))
+            return false;
+        for (auto symbol : symbols) {
+            row nextP = first.Step(p, symbol);
+            row nextQ = second.Step(q, symbol);
+            if (sets.Unite(nextP, offset + nextQ))
+                toCheck.emplace_back(nextP, nextQ);
+        }
+    }
+    return true;
+}
+
+bool automaton::IsIncluded(const Matcher& smaller, const Matcher& larger)
+{
+    auto symbols = smaller.GetSymbols();
+    auto key = [](row p, row q) {
+        return (static_cast<std::uint64_t>(p) << 32) | q;
+    };
+
+    std::unordered_set<std::uint64_t> visited{key(smaller.GetStartState(), larger.GetStartState())};
+    std::vector<std::pair<row, row>> toCheck{{smaller.GetStartState(), larger.GetStartState()}};
+    while (!toCheck.empty()) {
+        auto [p, q] = toCheck.back();
+        toCheck.pop_back();
+        if (smaller.IsAccepting(p) && !larger.IsAccepting(q))
+            return false;
+        for (auto symbol : symbols) {
+            row nextP = smaller.Step(p, symbol);
+            //once the smaller automaton is dead nothing below can be accepted by it
+            if (nextP == 0)
+                continue;
+            row nextQ = larger.Step(q, symbol);
+            if (visited.insert(key(nextP, nextQ)).second)
+                toCheck.emplace_back(nextP, nextQ);
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> automaton::DeduplicatePatterns(const std::vector<std::string>& patterns, Engine engine)
+{
+    //the automata are only walked, never searched with, so they get no search table
+    std::vector<std::optional<Matcher>> matchers(patterns.size());
+    std::vector<LanguageProfile> profiles(patterns.size());
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        matchers[i].emplace(CompileRegex(patterns[i], {Layout::Original, {}, engine, false}));
+        profiles[i] = Profile(*matchers[i]);
+    }
+
+    //equivalent patterns have equal profiles, so Hopcroft-Karp only runs inside a bucket; the first pattern
+    //of every class represents it
+    std::map<std::pair<std::string, std::string>, std::vector<std::size_t>> buckets;
+    std::vector<std::size_t> representatives;
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        auto& bucket = buckets[{profiles[i].symbols, profiles[i].shortest}];
+        bool equivalent = std::any_of(bucket.begin(), bucket.end(), [&](std::size_t representative) {
+            return AreEquivalent(*matchers[i], *matchers[representative]);
+        });
+        if (equivalent) {
+            matchers[i].reset();
+            continue;
+        }
+        bucket.push_back(i);
+        representatives.push_back(i);
+    }
+
+    //inclusion between the classes, the profiles rule most pairs out before the product is explored
+    auto included = [&](std::size_t smaller, std::size_t larger) {
+        const auto& profile = profiles[smaller];
+        if (profile.empty)
+            return true;
+        return std::includes(profiles[larger].symbols.begin(), profiles[larger].symbols.end(), profile.symbols.begin(), profile.symbols.end())
+               && matchers[larger]->Match(profile.shortest)
+               && IsIncluded(*matchers[smaller], *matchers[larger]);
+    };
+    std::vector<std::size_t> kept;
+    for (auto i : representatives) {
+        if (std::any_of(kept.begin(), kept.end(), [&](std::size_t other) { return included(i, other); }))
+            continue;
+        std::erase_if(kept, [&](std::size_t other) { return included(other, i); });
+        kept.push_back(i);
+    }
+
+    //the survivors keep their original relative order
+    std::sort(kept.begin(), kept.end());
+    std::vector<std::string> result;
+    for (auto index : kept) {
+        result.push_back(patterns[index]);
+    }
+    return result;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Matcher.h"
+#include <string>
+#include <vector>
+
+namespace automaton
+{
+    //Hopcroft-Karp: union-find over the states of both automata, near-linear in their size
+    bool AreEquivalent(const Matcher& first, const Matcher& second);
+    //L(smaller) is a subset of L(larger), checked on the fly over the reachable part of the product
+    bool IsIncluded(const Matcher& smaller, const Matcher& larger);
+
+    //keeps the first pattern of every equivalence class and drops the ones another kept pattern subsumes,
+    //the union of the kept patterns accepts exactly what the union of all patterns accepts
+    std::vector<std::string> DeduplicatePatterns(const std::vector<std::string>& patterns, Engine engine = Engine::Thompson);
+}
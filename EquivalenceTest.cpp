@@ -0,0 +1,54 @@
+#include "Check.h"
+#include "Equivalence.h"
+
+using namespace automaton;
+
+namespace
+{
+    Matcher Compile(const std::string& regex)
+    {
+        return CompileRegex(regex, {Layout::Original, {}, Engine::Thompson, false});
+    }
+
+    void TestEquivalence()
+    {
+        CHECK(AreEquivalent(Compile("(a|b)*"), Compile("(a*.b*)*")));
+        CHECK(AreEquivalent(Compile("a.(b|c)"), Compile("a.b|a.c")));
+        CHECK(!AreEquivalent(Compile("a.b*"), Compile("a.b.b*")));
+        CHECK(!AreEquivalent(Compile("a"), Compile("b")));
+    }
+
+    void TestInclusion()
+    {
+        CHECK(IsIncluded(Compile("a.b.b"), Compile("a.b*")));
+        CHECK(IsIncluded(Compile("a.b|a.c"), Compile("a.(b|c|d)")));
+        CHECK(!IsIncluded(Compile("a.b*"), Compile("a.b.b")));
+        CHECK(!IsIncluded(Compile("a.b.c"), Compile("a.b")));
+    }
+
+    void TestDeduplication()
+    {
+        //equivalent patterns keep the first one, subsumed ones go whatever their position
+        std::vector<std::string> patterns{"a.b", "(a.b)|(a.b)", "a.b*", "c", "c|d", "x.y*.z", "x.(y.y)*.z", "q"};
+        std::vector<std::string> expected{"a.b*", "c|d", "x.y*.z", "q"};
+        CHECK(DeduplicatePatterns(patterns) == expected);
+        CHECK(DeduplicatePatterns(patterns, Engine::Derivative) == expected);
+        CHECK(DeduplicatePatterns(patterns, Engine::Glushkov) == expected);
+
+        //the union of what is kept accepts exactly what the union of everything accepts
+        auto all = Compile(JoinAlternatives(patterns));
+        auto kept = Compile(JoinAlternatives(DeduplicatePatterns(patterns)));
+        CHECK(AreEquivalent(all, kept));
+
+        std::vector<std::string> words{"w.o.r.d", "w.o.r.d.s", "w.o.r.d", "w.o.r.(d|k)"};
+        CHECK((DeduplicatePatterns(words) == std::vector<std::string>{"w.o.r.d.s", "w.o.r.(d|k)"}));
+    }
+}
+
+int main()
+{
+    TestEquivalence();
+    TestInclusion();
+    TestDeduplication();
+    return test::Result();
+}
@@ -0,0 +1,137 @@
+#include "Glushkov.h"
+#include <array>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+using namespace automaton;
+
+namespace
+{
+    //positions a subexpression can start and end with
+    struct Fragment
+    {
+        std::vector<state> first;
+        std::vector<state> last;
+        bool nullable;
+    };
+}
+
+PositionAutomaton::PositionAutomaton(const std::string& regex)
+    : Automaton{0, 0}
+{
+    std::stack<Fragment> fragments;
+    std::vector<char> symbols{0};
+    auto follow = [&](const std::vector<state>& from, const std::vector<state>& to) {
+        for (state q : from) {
+            for (state p : to) {
+                m_deltaFunction[{q, symbols[p]}].insert(p);
+            }
+        }
+    };
+
+    for (char character : RegexToPolishForm(regex)) {
+        if (IsSymbol(character)) {
+            if (symbols.size() >= std::numeric_limits<state>::max())
+                throw std::length_error("regex has too many symbols");
+            auto position = static_cast<state>(symbols.size());
+            symbols.push_back(character);
+            m_states.insert(position);
+            m_alphabet.insert(character);
+            fragments.push({{position}, {position}, false});
+            continue;
+        }
+        auto right = std::move(fragments.top());
+        fragments.pop();
+        if (character == '*') {
+            follow(right.last, right.first);
+            right.nullable = true;
+            fragments.push(std::move(right));
+            continue;
+        }
+        auto left = std::move(fragments.top());
+        fragments.pop();
+        if (character == '.') {
+            follow(left.last, right.first);
+            if (left.nullable)
+                left.first.insert(left.first.end(), right.first.begin(), right.first.end());
+            if (right.nullable)
+                right.last.insert(right.last.end(), left.last.begin(), left.last.end());
+            fragments.push({std::move(left.first), std::move(right.last), left.nullable && right.nullable});
+        }
+        else {
+            left.first.insert(left.first.end(), right.first.begin(), right.first.end());
+            left.last.insert(left.last.end(), right.last.begin(), right.last.end());
+            left.nullable = left.nullable || right.nullable;
+            fragments.push(std::move(left));
+        }
+    }
+
+    //the first and last sets of a subexpression never repeat a position, so they need no deduplication
+    const auto& regexFragment = fragments.top();
+    follow({m_initialState}, regexFragment.first);
+    m_finalStates.insert(regexFragment.last.begin(), regexFragment.last.end());
+    if (regexFragment.nullable)
+        m_finalStates.insert(m_initialState);
+    m_finalState = *std::min_element(m_finalStates.begin(), m_finalStates.end());
+}
+
+const std::unordered_set<state>& PositionAutomaton::GetFinalStates() const
+{
+    return m_finalStates;
+}
+
+DeterministicFiniteAutomaton automaton::BuildGlushkovAutomaton(const std::string& regex)
+{
+    PositionAutomaton positions(regex);
+
+    //every edge into a position carries the symbol of that position, so one pass over the follow sets of a
+    //subset splits them by symbol into all of its successors
+    std::vector<std::vector<state>> follow(positions.GetStates().size());
+    std::vector<char> symbols(positions.GetStates().size());
+    for (const auto& [input, targets] : positions.GetDeltaFunction()) {
+        for (state p : targets) {
+            follow[input.first].push_back(p);
+            symbols[p] = std::get<char>(input.second);
+        }
+    }
+
+    std::array<std::size_t, 256> column{};
+    std::vector<char> alphabet(positions.GetAlphabet().begin(), positions.GetAlphabet().end());
+    for (std::size_t i = 0; i < alphabet.size(); ++i) {
+        column[static_cast<unsigned char>(alphabet[i])] = i;
+    }
+
+    std::map<std::vector<state>, state> subsets{{{positions.GetStartState()}, 0}};
+    std::vector<const std::vector<state>*> order{&subsets.begin()->first};
+    std::unordered_map<transition, std::unordered_set<state>, Hash> deltaFunction;
+    std::unordered_set<state> finalStates;
+    std::vector<std::vector<state>> successors(alphabet.size());
+
+    for (std::size_t current = 0; current < order.size(); ++current) {
+        for (state q : *order[current]) {
+            if (positions.GetFinalStates().contains(q))
+                finalStates.insert(static_cast<state>(current));
+            for (state p : follow[q]) {
+                successors[column[static_cast<unsigned char>(symbols[p])]].push_back(p);
+            }
+        }
+        for (std::size_t i = 0; i < alphabet.size(); ++i) {
+            auto& successor = successors[i];
+            if (successor.empty())
+                continue;
+            std::sort(successor.begin(), successor.end());
+            successor.erase(std::unique(successor.begin(), successor.end()), successor.end());
+            auto [it, inserted] = subsets.try_emplace(std::move(successor), static_cast<state>(order.size()));
+            if (inserted) {
+                if (order.size() >= std::numeric_limits<state>::max())
+                    throw std::length_error("Glushkov automaton has too many states");
+                order.push_back(&it->first);
+            }
+            deltaFunction[{static_cast<state>(current), alphabet[i]}] = {it->second};
+            successor.clear();
+        }
+    }
+
+    return DeterministicFiniteAutomaton{0, order.size(), positions.GetAlphabet(), deltaFunction, finalStates};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "DFA.h"
+
+namespace automaton
+{
+    //Glushkov construction: state 0 is the start and state p is the p-th symbol of the regex, a transition into p
+    //is always labelled with that symbol; n symbols give exactly n + 1 states and there are no lambda-edges
+    class PositionAutomaton : public Automaton
+    {
+    public:
+        explicit PositionAutomaton(const std::string& regex);
+
+    public:
+        const std::unordered_set<state>& GetFinalStates() const;
+
+    private:
+        std::unordered_set<state> m_finalStates;
+    };
+
+    //subset construction over the position automaton, without any closure computation
+    DeterministicFiniteAutomaton BuildGlushkovAutomaton(const std::string& regex);
+}
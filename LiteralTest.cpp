@@ -0,0 +1,83 @@
+#include "Check.h"
+#include "Equivalence.h"
+#include <random>
+
+using namespace automaton;
+
+namespace
+{
+    std::vector<std::string> RandomWords(std::size_t count, std::size_t maxLength, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<std::string> words(count);
+        for (auto& word : words) {
+            word.resize(1 + random() % maxLength);
+            for (auto& c : word) {
+                c = static_cast<char>('a' + random() % 26);
+            }
+        }
+        return words;
+    }
+
+    std::string Dotted(const std::string& word)
+    {
+        std::string result;
+        for (char c : word) {
+            if (!result.empty())
+                result += '.';
+            result += c;
+        }
+        return result;
+    }
+
+    //the trie accepts the same words as the DFA of their alternation
+    void TestAgainstAutomaton()
+    {
+        for (unsigned seed = 0; seed < 20; ++seed) {
+            auto words = RandomWords(30, 6, seed);
+            std::vector<std::string> patterns;
+            for (const auto& word : words) {
+                patterns.push_back(Dotted(word));
+            }
+            auto regex = JoinAlternatives(patterns);
+            CHECK(ExtractLiterals(regex) == words);
+
+            auto trie = Matcher::FromLiterals(words);
+            Matcher automat(BuildDeterministicAutomaton(regex, Engine::Thompson));
+            automat.BuildSearchTable();
+            CHECK(AreEquivalent(trie, automat));
+            for (const auto& text : RandomWords(200, 12, seed + 100)) {
+                CHECK(trie.Search(text) == automat.Search(text));
+            }
+        }
+    }
+
+    //more trie nodes than a 16-bit state can number
+    void TestLargeList()
+    {
+        auto words = RandomWords(30000, 12, 1);
+        auto matcher = CompileRegex(JoinAlternatives([&] {
+            std::vector<std::string> patterns;
+            for (const auto& word : words) {
+                patterns.push_back(Dotted(word));
+            }
+            return patterns;
+        }()));
+        CHECK(matcher.StateCount() > 65536);
+        for (const auto& word : words) {
+            CHECK(matcher.Match(word));
+            CHECK(matcher.Search("0" + word + "0"));
+        }
+        for (const auto& text : RandomWords(1000, 3, 2)) {
+            bool listed = std::find(words.begin(), words.end(), text) != words.end();
+            CHECK(matcher.Match(text) == listed);
+        }
+    }
+}
+
+int main()
+{
+    TestAgainstAutomaton();
+    TestLargeList();
+    return test::Result();
+}
@@ -0,0 +1,605 @@
+#include "Matcher.h"
+#include "Derivative.h"
+#include "Glushkov.h"
+#include <cstring>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace automaton;
+
+Matcher::Matcher(const DeterministicFiniteAutomaton& automat)
+    : m_columns{automat.GetAlphabet().size() + 1}
+{
+    //column 0 is shared by every byte outside the alphabet
+    std::uint8_t column = 1;
+    for (char symbol : automat.GetAlphabet()) {
+        m_classes[static_cast<unsigned char>(symbol)] = column;
+        column += 1;
+    }
+
+    //one row per state after the dead state, and every row has to be reachable with a state
+    std::size_t rows = automat.GetStartState() + std::size_t{1};
+    for (state elem : automat.GetStates()) {
+        rows = std::max<std::size_t>(rows, elem + std::size_t{1});
+    }
+    rows += 1;
+    if (rows - 1 > std::numeric_limits<row>::max())
+        throw std::length_error("automaton has too many states for the transition table");
+
+    m_anchored.next.assign(rows * m_columns, 0);
+    m_anchored.accepting.assign(rows, 0);
+    for (const auto& [input, output] : automat.GetDeltaFunction()) {
+        if (!std::holds_alternative<char>(input.second) || output.empty())
+            continue;
+        auto symbol = static_cast<unsigned char>(std::get<char>(input.second));
+        m_anchored.next[(input.first + 1) * m_columns + m_classes[symbol]] = *output.begin() + 1;
+    }
+    for (state elem : automat.GetFinalStates()) {
+        m_anchored.accepting[elem + 1] = 1;
+    }
+    m_anchored.start = automat.GetStartState() + 1;
+    FlagStates(m_anchored, true);
+}
+
+Matcher Matcher::Union(const Matcher& first, const Matcher& second)
+{
+    Matcher result;
+
+    //bytes that both automata treat the same way share a column
+    std::map<std::pair<std::uint8_t, std::uint8_t>, std::uint8_t> columns{{{0, 0}, 0}};
+    std::vector<std::pair<std::uint8_t, std::uint8_t>> columnPairs{{0, 0}};
+    for (std::size_t symbol = 0; symbol < result.m_classes.size(); ++symbol) {
+        std::pair classes{first.m_classes[symbol], second.m_classes[symbol]};
+        auto [it, inserted] = columns.try_emplace(classes, static_cast<std::uint8_t>(columnPairs.size()));
+        if (inserted)
+            columnPairs.push_back(classes);
+        result.m_classes[symbol] = it->second;
+    }
+    result.m_columns = columnPairs.size();
+
+    if (!Product(first, second, columnPairs, true, result.m_anchored))
+        throw std::length_error("union of the automata has too many states");
+    result.Minimize(result.m_anchored, true);
+    result.FlagStates(result.m_anchored, true);
+
+    //a search table accepts the texts with a match somewhere, and those of a union are the union of those of
+    //both automata, so the product of their search tables is one too
+    if (first.HasSearchTable() && second.HasSearchTable() && Product(first, second, columnPairs, false, result.m_search)) {
+        result.Minimize(result.m_search, false);
+        result.FlagStates(result.m_search, false);
+    }
+    else {
+        result.m_search = {};
+    }
+    return result;
+}
+
+//product of the anchored or the search tables of both automata over the merged columns, false if it has more
+//rows than a DFA state can number, like the subset constructions; the pair of dead states is the dead state of
+//the anchored product
+bool Matcher::Product(const Matcher& first, const Matcher& second, const std::vector<std::pair<std::uint8_t, std::uint8_t>>& columnPairs,
+                      bool anchored, Table& table)
+{
+    const auto& firstTable = anchored ? first.m_anchored : first.m_search;
+    const auto& secondTable = anchored ? second.m_anchored : second.m_search;
+    std::unordered_map<std::uint64_t, row> indices;
+    std::vector<std::pair<row, row>> pairs;
+    if (anchored) {
+        indices.emplace(0, 0);
+        pairs.emplace_back(0, 0);
+    }
+    bool overflow = false;
+    auto intern = [&](row p, row q) {
+        auto [it, inserted] = indices.try_emplace((static_cast<std::uint64_t>(p) << 32) | q, static_cast<row>(pairs.size()));
+        if (inserted) {
+            overflow = overflow || pairs.size() >= std::numeric_limits<state>::max();
+            pairs.emplace_back(p, q);
+        }
+        return it->second;
+    };
+
+    std::size_t columns = columnPairs.size();
+    table = {};
+    table.start = intern(firstTable.start, secondTable.start);
+    for (std::size_t i = 0; i < pairs.size() && !overflow; ++i) {
+        auto [p, q] = pairs[i];
+        table.accepting.push_back(firstTable.accepting[p] | secondTable.accepting[q]);
+        table.next.resize((i + 1) * columns);
+        for (std::size_t column = 0; column < columns; ++column) {
+            auto [firstColumn, secondColumn] = columnPairs[column];
+            table.next[i * columns + column] = intern(firstTable.next[p * first.m_columns + firstColumn],
+                                                      secondTable.next[q * second.m_columns + secondColumn]);
+        }
+    }
+    if (overflow)
+        table = {};
+    return !overflow;
+}
+
+Matcher Matcher::FromLiterals(const std::vector<std::string>& literals)
+{
+    Matcher result;
+    for (const auto& literal : literals) {
+        for (unsigned char symbol : literal) {
+            if (result.m_classes[symbol] != 0)
+                continue;
+            if (result.m_columns > std::numeric_limits<std::uint8_t>::max())
+                throw std::length_error("too many distinct bytes in the words");
+            result.m_classes[symbol] = static_cast<std::uint8_t>(result.m_columns);
+            result.m_columns += 1;
+        }
+    }
+    auto columns = result.m_columns;
+
+    //row 0 is the dead state and row 1 the root of the trie
+    auto& trie = result.m_anchored;
+    trie.next.assign(2 * columns, 0);
+    trie.accepting.assign(2, 0);
+    trie.start = 1;
+    for (const auto& literal : literals) {
+        row current = trie.start;
+        for (unsigned char symbol : literal) {
+            auto index = current * columns + result.m_classes[symbol];
+            if (trie.next[index] == 0) {
+                if (trie.accepting.size() >= std::numeric_limits<row>::max())
+                    throw std::length_error("trie of the words has too many states");
+                trie.next[index] = static_cast<row>(trie.accepting.size());
+                trie.next.resize(trie.next.size() + columns, 0);
+                trie.accepting.push_back(0);
+            }
+            current = trie.next[index];
+        }
+        trie.accepting[current] = 1;
+    }
+
+    //trie node i is search row i - 1; a missing edge goes where the failure link of the node goes, and the
+    //failure links are known breadth-first since they always point to a shallower node
+    auto& search = result.m_search;
+    std::size_t rows = trie.accepting.size() - 1;
+    search.next.assign(rows * columns, 0);
+    search.accepting.assign(rows, 0);
+    search.start = 0;
+    std::vector<row> failure(rows, 0);
+    std::vector<row> order{0};
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        row current = order[i];
+        for (std::size_t column = 0; column < columns; ++column) {
+            row child = trie.next[(current + 1) * columns + column];
+            if (child == 0) {
+                search.next[current * columns + column] = current == 0 ? 0 : search.next[failure[current] * columns + column];
+                continue;
+            }
+            child -= 1;
+            search.next[current * columns + column] = child;
+            failure[child] = current == 0 ? 0 : search.next[failure[current] * columns + column];
+            search.accepting[child] = trie.accepting[child + 1] | search.accepting[failure[child]];
+            order.push_back(child);
+        }
+    }
+
+    result.FlagStates(trie, true);
+    result.FlagStates(search, false);
+    return result;
+}
+
+//Moore partition refinement, the block of the dead state becomes row 0 of an anchored table
+void Matcher::Minimize(Table& table, bool hasDeadState) const
+{
+    struct SignatureHash
+    {
+        std::size_t operator () (const std::vector<row>& signature) const
+        {
+            std::size_t seed = signature.size();
+            for (row elem : signature) {
+                seed ^= elem + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    std::size_t rows = table.accepting.size();
+    std::vector<row> block(table.accepting.begin(), table.accepting.end());
+    std::size_t blockCount = 0;
+    std::unordered_map<std::vector<row>, row, SignatureHash> signatures;
+    std::vector<row> signature(m_columns + 1);
+    while (true) {
+        signatures.clear();
+        signatures.reserve(rows);
+        std::vector<row> refined(rows);
+        for (std::size_t current = 0; current < rows; ++current) {
+            signature[0] = block[current];
+            for (std::size_t column = 0; column < m_columns; ++column) {
+                signature[column + 1] = block[table.next[current * m_columns + column]];
+            }
+            refined[current] = signatures.try_emplace(signature, static_cast<row>(signatures.size())).first->second;
+        }
+        block = std::move(refined);
+        if (signatures.size() == blockCount)
+            break;
+        blockCount = signatures.size();
+    }
+
+    std::vector<row> newIndex(blockCount, std::numeric_limits<row>::max());
+    std::vector<row> representatives;
+    if (hasDeadState) {
+        newIndex[block[0]] = 0;
+        representatives.push_back(0);
+    }
+    for (std::size_t current = 0; current < rows; ++current) {
+        if (newIndex[block[current]] == std::numeric_limits<row>::max()) {
+            newIndex[block[current]] = static_cast<row>(representatives.size());
+            representatives.push_back(static_cast<row>(current));
+        }
+    }
+
+    Table minimized;
+    for (std::size_t i = 0; i < representatives.size(); ++i) {
+        for (std::size_t column = 0; column < m_columns; ++column) {
+            minimized.next.push_back(newIndex[block[table.next[representatives[i] * m_columns + column]]]);
+        }
+        minimized.accepting.push_back(table.accepting[representatives[i]]);
+    }
+    minimized.start = newIndex[block[table.start]];
+    table = std::move(minimized);
+}
+
+bool Matcher::HasSearchTable() const
+{
+    return !m_search.accepting.empty();
+}
+
+void Matcher::BuildSearchTable()
+{
+    //subset construction over the anchored table, re-entering the start state at every position
+    std::map<std::vector<row>, row> indices;
+    std::vector<std::vector<row>> subsets;
+    auto intern = [&](std::vector<row> subset) {
+        std::sort(subset.begin(), subset.end());
+        subset.erase(std::unique(subset.begin(), subset.end()), subset.end());
+        auto [it, inserted] = indices.try_emplace(subset, static_cast<row>(subsets.size()));
+        if (inserted)
+            subsets.push_back(std::move(subset));
+        return it->second;
+    };
+
+    m_search = {};
+    m_search.start = intern({m_anchored.start});
+    for (std::size_t i = 0; i < subsets.size(); ++i) {
+        if (subsets.size() >= std::numeric_limits<state>::max()) {
+            //too many subsets to index, Search falls back to restarting the anchored table
+            m_search = {};
+            return;
+        }
+        auto current = subsets[i];
+        std::uint8_t accepting = 0;
+        for (row elem : current) {
+            accepting |= m_anchored.accepting[elem];
+        }
+        m_search.accepting.push_back(accepting);
+        m_search.next.resize((i + 1) * m_columns);
+        for (std::size_t column = 0; column < m_columns; ++column) {
+            std::vector<row> next{m_anchored.start};
+            for (row elem : current) {
+                if (row target = m_anchored.next[elem * m_columns + column])
+                    next.push_back(target);
+            }
+            m_search.next[i * m_columns + column] = intern(std::move(next));
+        }
+    }
+    FlagStates(m_search, false);
+}
+
+void Matcher::FlagStates(Table& table, bool hasDeadState) const
+{
+    std::size_t rows = table.accepting.size();
+    table.flags.assign(rows, 0);
+    table.exitCount.assign(rows, 0);
+    table.exits.assign(rows, {});
+    for (std::size_t current = 0; current < rows; ++current) {
+        if (table.accepting[current])
+            table.flags[current] |= acceptingFlag;
+    }
+    if (hasDeadState && rows > 0)
+        table.flags[0] |= deadFlag;
+}
+
+void Matcher::FlagSelfLoops(Table& table, const VisitCounts& counts) const
+{
+    for (std::size_t current = 0; current < table.accepting.size(); ++current) {
+        auto entries = counts.visits[current] - counts.selfLoops[current];
+        if (table.flags[current] || entries == 0 || counts.visits[current] < entries * minRunLength)
+            continue;
+        std::vector<unsigned char> exits;
+        for (std::size_t symbol = 0; symbol < m_classes.size() && exits.size() <= maxExits; ++symbol) {
+            if (table.next[current * m_columns + m_classes[symbol]] != current)
+                exits.push_back(static_cast<unsigned char>(symbol));
+        }
+        if (exits.empty() || exits.size() > maxExits)
+            continue;
+        table.flags[current] |= selfLoopFlag;
+        table.exitCount[current] = static_cast<std::uint8_t>(exits.size());
+        //unused slots repeat the first exit so the exits can be compared without looking at the count
+        table.exits[current].fill(exits.front());
+        std::copy(exits.begin(), exits.end(), table.exits[current].begin());
+    }
+}
+
+//first byte at or after position that leaves the self-looping state; the next few bytes are checked
+//directly since exits are often close, after that memchr looks for them a window at a time
+const unsigned char* Matcher::SkipSelfLoop(const Table& table, row current, const unsigned char* position, const unsigned char* end)
+{
+    constexpr std::size_t inlineBytes = 16;
+    constexpr std::size_t window = 4096;
+    const auto& exits = table.exits[current];
+    for (std::size_t i = 0; i < inlineBytes && position != end; ++i, ++position) {
+        if (*position == exits[0] || *position == exits[1] || *position == exits[2])
+            return position;
+    }
+    while (position < end) {
+        const unsigned char* windowEnd = end - position > static_cast<std::ptrdiff_t>(window) ? position + window : end;
+        const unsigned char* found = windowEnd;
+        for (std::size_t i = 0; i < table.exitCount[current]; ++i) {
+            auto* exit = static_cast<const unsigned char*>(std::memchr(position, exits[i], found - position));
+            if (exit)
+                found = exit;
+        }
+        if (found != windowEnd)
+            return found;
+        position = windowEnd;
+    }
+    return end;
+}
+
+void Matcher::Renumber(Table& table, const std::vector<row>& order, bool hasDeadState) const
+{
+    std::vector<row> newIndex(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        newIndex[order[i]] = static_cast<row>(i);
+    }
+
+    Table renumbered;
+    renumbered.next.resize(table.next.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        for (std::size_t column = 0; column < m_columns; ++column) {
+            renumbered.next[i * m_columns + column] = newIndex[table.next[order[i] * m_columns + column]];
+        }
+        renumbered.accepting.push_back(table.accepting[order[i]]);
+    }
+    renumbered.start = newIndex[table.start];
+    FlagStates(renumbered, hasDeadState);
+    table = std::move(renumbered);
+}
+
+//unreachable rows go last, the dead state of the anchored table has to stay row 0
+std::vector<row> Matcher::BreadthFirstOrder(const Table& table, bool pinDeadState) const
+{
+    std::size_t rows = table.accepting.size();
+    std::vector<std::uint8_t> visited(rows, 0);
+    std::vector<row> order;
+    if (pinDeadState) {
+        order.push_back(0);
+        visited[0] = 1;
+    }
+    if (!visited[table.start]) {
+        order.push_back(table.start);
+        visited[table.start] = 1;
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        for (std::size_t column = 0; column < m_columns; ++column) {
+            row next = table.next[order[i] * m_columns + column];
+            if (!visited[next]) {
+                visited[next] = 1;
+                order.push_back(next);
+            }
+        }
+    }
+    for (std::size_t current = 0; current < rows; ++current) {
+        if (!visited[current])
+            order.push_back(static_cast<row>(current));
+    }
+    return order;
+}
+
+Matcher::VisitCounts Matcher::CountVisits(const Table& table, std::string_view sample, bool search) const
+{
+    VisitCounts counts{std::vector<std::uint64_t>(table.accepting.size(), 0), std::vector<std::uint64_t>(table.accepting.size(), 0)};
+    while (!sample.empty()) {
+        auto newline = sample.find('\n');
+        auto record = sample.substr(0, newline);
+        sample.remove_prefix(newline == std::string_view::npos ? sample.size() : newline + 1);
+
+        row current = table.start;
+        counts.visits[current] += 1;
+        for (unsigned char symbol : record) {
+            if ((search && table.accepting[current]) || (!search && current == 0))
+                break;
+            row next = table.next[current * m_columns + m_classes[symbol]];
+            counts.visits[next] += 1;
+            counts.selfLoops[next] += next == current;
+            current = next;
+        }
+    }
+    return counts;
+}
+
+void Matcher::ApplyLayout(Layout layout, std::string_view sample)
+{
+    if (layout == Layout::Original)
+        return;
+
+    bool hasSearchTable = !m_search.accepting.empty();
+    auto anchoredOrder = BreadthFirstOrder(m_anchored, true);
+    auto searchOrder = hasSearchTable ? BreadthFirstOrder(m_search, false) : std::vector<row>{};
+    if (layout == Layout::Profile) {
+        auto hottestFirst = [](std::vector<row>& order, const VisitCounts& counts, std::size_t pinned) {
+            std::stable_sort(order.begin() + pinned, order.end(), [&](row first, row second) {
+                return counts.visits[first] > counts.visits[second];
+            });
+        };
+        hottestFirst(anchoredOrder, CountVisits(m_anchored, sample, false), 1);
+        if (hasSearchTable)
+            hottestFirst(searchOrder, CountVisits(m_search, sample, true), 0);
+    }
+
+    Renumber(m_anchored, anchoredOrder, true);
+    if (hasSearchTable)
+        Renumber(m_search, searchOrder, false);
+
+    //the visits are counted again since the rows moved
+    if (layout == Layout::Profile) {
+        FlagSelfLoops(m_anchored, CountVisits(m_anchored, sample, false));
+        if (hasSearchTable)
+            FlagSelfLoops(m_search, CountVisits(m_search, sample, true));
+    }
+}
+
+bool Matcher::Match(std::string_view text) const
+{
+    auto* position = reinterpret_cast<const unsigned char*>(text.data());
+    auto* end = position + text.size();
+    row current = m_anchored.start;
+    if (m_anchored.flags[current] & selfLoopFlag)
+        position = SkipSelfLoop(m_anchored, current, position, end);
+    while (position != end) {
+        current = m_anchored.next[current * m_columns + m_classes[*position]];
+        ++position;
+        if (m_anchored.flags[current] & (deadFlag | selfLoopFlag)) [[unlikely]] {
+            if (m_anchored.flags[current] & deadFlag)
+                return false;
+            position = SkipSelfLoop(m_anchored, current, position, end);
+        }
+    }
+    return m_anchored.accepting[current];
+}
+
+bool Matcher::Search(std::string_view text) const
+{
+    if (m_search.accepting.empty()) {
+        for (std::size_t begin = 0; begin <= text.size(); ++begin) {
+            row current = m_anchored.start;
+            for (std::size_t i = begin; current != 0; ++i) {
+                if (m_anchored.accepting[current])
+                    return true;
+                if (i == text.size())
+                    break;
+                current = m_anchored.next[current * m_columns + m_classes[static_cast<unsigned char>(text[i])]];
+            }
+        }
+        return false;
+    }
+
+    auto* position = reinterpret_cast<const unsigned char*>(text.data());
+    auto* end = position + text.size();
+    row current = m_search.start;
+    if (m_search.accepting[current])
+        return true;
+    if (m_search.flags[current] & selfLoopFlag)
+        position = SkipSelfLoop(m_search, current, position, end);
+    while (position != end) {
+        current = m_search.next[current * m_columns + m_classes[*position]];
+        ++position;
+        if (m_search.flags[current]) [[unlikely]] {
+            if (m_search.flags[current] & acceptingFlag)
+                return true;
+            position = SkipSelfLoop(m_search, current, position, end);
+        }
+    }
+    return false;
+}
+
+std::size_t Matcher::StateCount() const
+{
+    return m_anchored.accepting.size() - 1;
+}
+
+row Matcher::GetStartState() const
+{
+    return m_anchored.start;
+}
+
+row Matcher::Step(row current, unsigned char symbol) const
+{
+    return m_anchored.next[current * m_columns + m_classes[symbol]];
+}
+
+bool Matcher::IsAccepting(row current) const
+{
+    return m_anchored.accepting[current];
+}
+
+std::vector<unsigned char> Matcher::GetSymbols() const
+{
+    std::vector<unsigned char> symbols;
+    for (std::size_t symbol = 0; symbol < m_classes.size(); ++symbol) {
+        if (m_classes[symbol] != 0)
+            symbols.push_back(static_cast<unsigned char>(symbol));
+    }
+    return symbols;
+}
+
+DeterministicFiniteAutomaton automaton::BuildDeterministicAutomaton(const std::string& regex, Engine engine)
+{
+    if (engine == Engine::Derivative)
+        return BuildDerivativeAutomaton(regex);
+    if (engine == Engine::Glushkov)
+        return BuildGlushkovAutomaton(regex);
+    auto* nfa = BuildAutomaton(regex);
+    DeterministicFiniteAutomaton dfa(*nfa);
+    delete nfa;
+    return dfa;
+}
+
+Matcher automaton::CompileRegex(const std::string& regex, const CompileOptions& options)
+{
+    //word lists skip the automaton construction altogether
+    auto literals = ExtractLiterals(regex);
+    Matcher matcher = literals ? Matcher::FromLiterals(*literals) : Matcher{BuildDeterministicAutomaton(regex, options.engine)};
+    if (options.searchTable && !matcher.HasSearchTable())
+        matcher.BuildSearchTable();
+    matcher.ApplyLayout(options.layout, options.sample);
+    return matcher;
+}
+
+std::string automaton::JoinAlternatives(const std::vector<std::string>& patterns)
+{
+    if (patterns.size() == 1)
+        return patterns.front();
+    std::string result;
+    for (const auto& pattern : patterns) {
+        if (!result.empty())
+            result += '|';
+        result += "(" + pattern + ")";
+    }
+    return result;
+}
+
+std::optional<std::vector<std::string>> automaton::ExtractLiterals(const std::string& regex)
+{
+    std::vector<std::vector<std::string>> operands;
+    for (char character : RegexToPolishForm(regex)) {
+        if (character == '*' || operands.size() < (character == '.' || character == '|' ? 2u : 0u))
+            return std::nullopt;
+        if (character != '.' && character != '|') {
+            operands.push_back({std::string(1, character)});
+            continue;
+        }
+        auto right = std::move(operands.back());
+        operands.pop_back();
+        auto& left = operands.back();
+        if (character == '|') {
+            left.insert(left.end(), std::make_move_iterator(right.begin()), std::make_move_iterator(right.end()));
+        }
+        else if (left.size() == 1 && right.size() == 1) {
+            left.front() += right.front();
+        }
+        else {
+            return std::nullopt;
+        }
+    }
+    if (operands.size() != 1)
+        return std::nullopt;
+    return std::move(operands.front());
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "DFA.h"
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace automaton
+{
+    //how the rows of the transition tables are numbered
+    enum class Layout
+    {
+        Original,       //DFA numbering, i.e. m_primeStatesMapping order
+        BreadthFirst,   //breadth-first from the start state
+        Profile         //most visited first when scanning CompileOptions::sample, breadth-first for the rest
+    };
+
+    //how a regex becomes a DFA
+    enum class Engine
+    {
+        Thompson,       //lambda-NFA, then subset construction with lambda-closures
+        Derivative,     //Brzozowski derivatives, see Derivative.h
+        Glushkov        //lambda-free position automaton, then subset construction without closures, see Glushkov.h
+    };
+
+    struct CompileOptions
+    {
+        Layout layout = Layout::BreadthFirst;
+        std::string_view sample;
+        Engine engine = Engine::Thompson;
+        bool searchTable = true;    //false when only Match and the automaton operations are needed
+    };
+
+    //index of a row in the Matcher tables; wider than state so that the tries of long word lists fit
+    using row = std::uint32_t;
+
+    //flat, byte-indexed copy of a DFA used for scanning text; row 0 is the dead state
+    class Matcher
+    {
+    public:
+        //only the anchored table, Search needs BuildSearchTable first
+        explicit Matcher(const DeterministicFiniteAutomaton& automat);
+        //minimal DFA of the union of both languages, with a search table when both automata have one
+        static Matcher Union(const Matcher& first, const Matcher& second);
+        //Aho-Corasick: the anchored table is the trie of the words and the search table follows its failure links
+        static Matcher FromLiterals(const std::vector<std::string>& literals);
+
+    public:
+        bool Match(std::string_view text) const;
+        bool Search(std::string_view text) const;
+        std::size_t StateCount() const;
+        row GetStartState() const;
+        row Step(row current, unsigned char symbol) const;
+        bool IsAccepting(row current) const;
+        std::vector<unsigned char> GetSymbols() const;
+        void ApplyLayout(Layout layout, std::string_view sample = {});
+        bool HasSearchTable() const;
+        void BuildSearchTable();
+
+    private:
+        //a state that leaves itself on at most maxExits bytes, and stayed in itself for at least minRunLength
+        //bytes per visit in the profile sample, is skipped with memchr as soon as it is entered
+        static constexpr std::size_t maxExits = 3;
+        static constexpr std::uint64_t minRunLength = 16;
+        static constexpr std::uint8_t acceptingFlag = 1;
+        static constexpr std::uint8_t selfLoopFlag = 2;
+        static constexpr std::uint8_t deadFlag = 4;
+
+        struct Table
+        {
+            std::vector<row> next;
+            std::vector<std::uint8_t> accepting;
+            std::vector<std::uint8_t> flags;
+            std::vector<std::uint8_t> exitCount;
+            std::vector<std::array<unsigned char, maxExits>> exits;
+            row start = 0;
+        };
+
+        struct VisitCounts
+        {
+            std::vector<std::uint64_t> visits;
+            std::vector<std::uint64_t> selfLoops;
+        };
+
+        Matcher() = default;
+        static bool Product(const Matcher& first, const Matcher& second, const std::vector<std::pair<std::uint8_t, std::uint8_t>>& columnPairs,
+                            bool anchored, Table& table);
+        void Minimize(Table& table, bool hasDeadState) const;
+        void FlagStates(Table& table, bool hasDeadState) const;
+        void FlagSelfLoops(Table& table, const VisitCounts& counts) const;
+        void Renumber(Table& table, const std::vector<row>& order, bool hasDeadState) const;
+        std::vector<row> BreadthFirstOrder(const Table& table, bool pinDeadState) const;
+        VisitCounts CountVisits(const Table& table, std::string_view sample, bool search) const;
+        static const unsigned char* SkipSelfLoop(const Table& table, row current, const unsigned char* position, const unsigned char* end);
+
+    private:
+        std::array<std::uint8_t, 256> m_classes{};
+        std::size_t m_columns = 1;
+        Table m_anchored;
+        Table m_search;
+    };
+
+    DeterministicFiniteAutomaton BuildDeterministicAutomaton(const std::string& regex, Engine engine);
+    Matcher CompileRegex(const std::string& regex, const CompileOptions& options = {});
+    std::string JoinAlternatives(const std::vector<std::string>& patterns);
+    //the words of a regex that only alternates concatenations of symbols, like w.o.r.d|o.t.h.e.r
+    std::optional<std::vector<std::string>> ExtractLiterals(const std::string& regex);
+}
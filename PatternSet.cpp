@@ -0,0 +1,172 @@
+#include "PatternSet.h"
+#include <bit>
+#include <stdexcept>
+
+using namespace automaton;
+
+namespace
+{
+    std::shared_ptr<const Matcher> Combine(const std::shared_ptr<const Matcher>& first, const std::shared_ptr<const Matcher>& second)
+    {
+        if (!first)
+            return second;
+        if (!second)
+            return first;
+        return std::make_shared<const Matcher>(Matcher::Union(*first, *second));
+    }
+}
+
+bool PatternSnapshot::Match(std::string_view text) const
+{
+    return (words && words->Match(text)) || (expressions && expressions->Match(text));
+}
+
+bool PatternSnapshot::Search(std::string_view text) const
+{
+    return (words && words->Search(text)) || (expressions && expressions->Search(text));
+}
+
+std::size_t PatternSet::Add(const std::string& regex, Engine engine)
+{
+    if (!ValidateRegex(regex))
+        throw std::invalid_argument("invalid regex " + regex);
+    //the leaves only feed unions, which take their search tables but never their layout
+    auto words = ExtractLiterals(regex);
+    std::shared_ptr<const Matcher> leaf;
+    if (!words)
+        leaf = std::make_shared<const Matcher>(CompileRegex(regex, {Layout::Original, {}, engine}));
+
+    //everything that can throw happens before the set changes, so a failed Add leaves it as it was
+    std::lock_guard lock(m_writer);
+    if (m_freeIds.empty())
+        Grow();
+    std::size_t id = m_freeIds.back();
+    auto wordMatcher = m_wordMatcher;
+    std::vector<std::shared_ptr<const Matcher>> path;
+    if (words) {
+        m_words.emplace(id, std::move(*words));
+        try {
+            wordMatcher = BuildWords();
+        }
+        catch (...) {
+            m_words.erase(id);
+            throw;
+        }
+    }
+    else {
+        path = Path(id, std::move(leaf));
+    }
+    auto snapshot = MakeSnapshot(wordMatcher, path.empty() ? Root() : path.back());
+
+    m_freeIds.pop_back();
+    m_size += 1;
+    Commit(id, std::move(path), std::move(wordMatcher), std::move(snapshot));
+    return id;
+}
+
+bool PatternSet::Remove(std::size_t id)
+{
+    std::lock_guard lock(m_writer);
+    auto wordMatcher = m_wordMatcher;
+    std::vector<std::shared_ptr<const Matcher>> path;
+    if (auto rule = m_words.extract(id)) {
+        try {
+            wordMatcher = BuildWords();
+            m_freeIds.push_back(id);
+        }
+        catch (...) {
+            m_words.insert(std::move(rule));
+            throw;
+        }
+    }
+    else if (id < m_capacity && m_nodes[m_capacity + id]) {
+        path = Path(id, nullptr);
+        m_freeIds.push_back(id);
+    }
+    else {
+        return false;
+    }
+
+    std::shared_ptr<const PatternSnapshot> snapshot;
+    if (m_size > 1)
+        snapshot = MakeSnapshot(wordMatcher, path.empty() ? Root() : path.back());
+    m_size -= 1;
+    Commit(id, std::move(path), std::move(wordMatcher), std::move(snapshot));
+    return true;
+}
+
+std::shared_ptr<const PatternSnapshot> PatternSet::Snapshot() const
+{
+    return m_current.load();
+}
+
+std::size_t PatternSet::Size() const
+{
+    std::lock_guard lock(m_writer);
+    return m_size;
+}
+
+//doubles the leaves; the old tree becomes the left subtree of the new root, so nothing is recomputed
+void PatternSet::Grow()
+{
+    std::size_t capacity = std::max<std::size_t>(1, m_capacity * 2);
+    std::vector<std::shared_ptr<const Matcher>> nodes(2 * capacity);
+    //allocated up front so nothing below can throw once the old nodes are moved out
+    m_freeIds.reserve(m_freeIds.size() + capacity - m_capacity);
+    for (std::size_t i = 1; i < m_nodes.size(); ++i) {
+        std::size_t depth = std::bit_width(i) - 1;
+        nodes[i + (std::size_t{1} << depth)] = std::move(m_nodes[i]);
+    }
+    if (m_capacity > 0)
+        nodes[1] = nodes[2];
+
+    for (std::size_t id = capacity; id-- > m_capacity;) {
+        m_freeIds.push_back(id);
+    }
+    m_nodes = std::move(nodes);
+    m_capacity = capacity;
+}
+
+//the unions from the leaf of id up to the root once the leaf is replaced, the leaf first and the root last
+std::vector<std::shared_ptr<const Matcher>> PatternSet::Path(std::size_t id, std::shared_ptr<const Matcher> leaf) const
+{
+    std::vector<std::shared_ptr<const Matcher>> path{std::move(leaf)};
+    for (std::size_t node = m_capacity + id; node > 1; node /= 2) {
+        const auto& sibling = m_nodes[node ^ 1];
+        path.push_back(node % 2 == 0 ? Combine(path.back(), sibling) : Combine(sibling, path.back()));
+    }
+    return path;
+}
+
+std::shared_ptr<const Matcher> PatternSet::Root() const
+{
+    return m_nodes.size() > 1 ? m_nodes[1] : nullptr;
+}
+
+//building the trie of all words again takes about as long as copying it would
+std::shared_ptr<const Matcher> PatternSet::BuildWords() const
+{
+    std::vector<std::string> words;
+    for (const auto& [id, rule] : m_words) {
+        words.insert(words.end(), rule.begin(), rule.end());
+    }
+    return words.empty() ? nullptr : std::make_shared<const Matcher>(Matcher::FromLiterals(words));
+}
+
+std::shared_ptr<const PatternSnapshot> PatternSet::MakeSnapshot(std::shared_ptr<const Matcher> words, std::shared_ptr<const Matcher> root)
+{
+    return std::make_shared<const PatternSnapshot>(std::move(words), std::move(root));
+}
+
+//only moves pointers, so it cannot fail halfway
+void PatternSet::Commit(std::size_t id, std::vector<std::shared_ptr<const Matcher>> path, std::shared_ptr<const Matcher> words,
+                        std::shared_ptr<const PatternSnapshot> snapshot) noexcept
+{
+    std::size_t node = m_capacity + id;
+    for (auto& matcher : path) {
+        m_nodes[node] = std::move(matcher);
+        node /= 2;
+    }
+    m_wordMatcher = std::move(words);
+    m_current.store(std::move(snapshot));
+}
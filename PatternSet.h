@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Matcher.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace automaton
+{
+    //one version of a PatternSet: the rules that are only words share an Aho-Corasick automaton and the
+    //other rules are the root of the union tree, either can be missing
+    struct PatternSnapshot
+    {
+        std::shared_ptr<const Matcher> words;
+        std::shared_ptr<const Matcher> expressions;
+
+        bool Match(std::string_view text) const;
+        bool Search(std::string_view text) const;
+    };
+
+    //alternatives that can be added and removed while other threads keep matching
+    //every alternative is compiled on its own once and the set is a tree of unions over them, so a change
+    //only rebuilds the unions on the path from its leaf to the root, search tables included; word lists
+    //skip the tree and are rebuilt into one trie, which is cheaper than any union. Readers keep the
+    //snapshot they took until the new one is swapped in
+    class PatternSet
+    {
+    public:
+        //ids of removed alternatives are handed out again
+        std::size_t Add(const std::string& regex, Engine engine = Engine::Thompson);
+        bool Remove(std::size_t id);
+        //nullptr while the set is empty
+        std::shared_ptr<const PatternSnapshot> Snapshot() const;
+        std::size_t Size() const;
+
+    private:
+        void Grow();
+        std::vector<std::shared_ptr<const Matcher>> Path(std::size_t id, std::shared_ptr<const Matcher> leaf) const;
+        std::shared_ptr<const Matcher> Root() const;
+        std::shared_ptr<const Matcher> BuildWords() const;
+        static std::shared_ptr<const PatternSnapshot> MakeSnapshot(std::shared_ptr<const Matcher> words, std::shared_ptr<const Matcher> root);
+        void Commit(std::size_t id, std::vector<std::shared_ptr<const Matcher>> path, std::shared_ptr<const Matcher> words,
+                    std::shared_ptr<const PatternSnapshot> snapshot) noexcept;
+
+    private:
+        mutable std::mutex m_writer;
+        std::vector<std::shared_ptr<const Matcher>> m_nodes;   //1-based heap, leaf of id i is m_nodes[m_capacity + i]
+        std::map<std::size_t, std::vector<std::string>> m_words;   //rules that are only words, by id
+        std::shared_ptr<const Matcher> m_wordMatcher;
+        std::vector<std::size_t> m_freeIds;
+        std::size_t m_capacity = 0;
+        std::size_t m_size = 0;
+        std::atomic<std::shared_ptr<const PatternSnapshot>> m_current;
+    };
+}
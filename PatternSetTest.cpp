@@ -0,0 +1,107 @@
+#include "Check.h"
+#include "PatternSet.h"
+#include "RandomRegex.h"
+
+using namespace automaton;
+
+namespace
+{
+    //the set must answer like the rules it holds, matched one by one
+    void CheckAgainstRules(const PatternSet& set, const std::map<std::size_t, Matcher>& rules, const std::vector<std::string>& texts)
+    {
+        auto snapshot = set.Snapshot();
+        CHECK((snapshot == nullptr) == rules.empty());
+        for (const auto& text : texts) {
+            bool match = false;
+            bool search = false;
+            for (const auto& [id, rule] : rules) {
+                match = match || rule.Match(text);
+                search = search || rule.Search(text);
+            }
+            CHECK((snapshot && snapshot->Match(text)) == match);
+            CHECK((snapshot && snapshot->Search(text)) == search);
+        }
+    }
+
+    void TestRandomChanges(Engine engine)
+    {
+        std::mt19937 random(7);
+        std::vector<std::string> texts;
+        for (int i = 0; i < 200; ++i) {
+            texts.push_back(test::RandomText(random, 5, 4));
+        }
+
+        PatternSet set;
+        std::map<std::size_t, Matcher> rules;
+        for (int step = 0; step < 150; ++step) {
+            if (!rules.empty() && random() % 3 == 0) {
+                auto it = std::next(rules.begin(), random() % rules.size());
+                CHECK(set.Remove(it->first));
+                CHECK(!set.Remove(it->first));
+                rules.erase(it);
+            }
+            else {
+                //every third rule is a word list, which takes the trie path
+                auto regex = step % 3 == 0 ? "a.b|c.a.b" : test::RandomRegex(random, 3);
+                auto id = set.Add(regex, engine);
+                CHECK(!rules.contains(id));
+                rules.emplace(id, CompileRegex(regex));
+            }
+            CHECK(set.Size() == rules.size());
+            CheckAgainstRules(set, rules, texts);
+        }
+
+        while (!rules.empty()) {
+            CHECK(set.Remove(rules.begin()->first));
+            rules.erase(rules.begin());
+            CheckAgainstRules(set, rules, texts);
+        }
+    }
+
+    std::string Cycle(std::size_t length)
+    {
+        std::string regex = "(a";
+        for (std::size_t i = 1; i < length; ++i) {
+            regex += ".a";
+        }
+        return regex + ")*";
+    }
+
+    //the union of cycles of 251 and 263 needs their product of states, which overflows; the set has to be left
+    //as it was before the failed Add
+    void TestFailedAdd()
+    {
+        PatternSet set;
+        auto first = set.Add(Cycle(251));
+        bool thrown = false;
+        try {
+            set.Add(Cycle(263));
+        }
+        catch (const std::length_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(set.Size() == 1);
+
+        auto second = set.Add("b.b*");
+        CHECK(set.Size() == 2);
+        CHECK(set.Remove(first));
+        CHECK(set.Size() == 1);
+        auto snapshot = set.Snapshot();
+        CHECK(snapshot && snapshot->Match("bb"));
+        CHECK(!snapshot->Match(std::string(263, 'a')));
+        CHECK(!snapshot->Match(std::string(251, 'a')));
+        CHECK(set.Remove(second));
+        CHECK(set.Size() == 0);
+        CHECK(set.Snapshot() == nullptr);
+    }
+}
+
+int main()
+{
+    TestRandomChanges(Engine::Thompson);
+    TestRandomChanges(Engine::Derivative);
+    TestRandomChanges(Engine::Glushkov);
+    TestFailedAdd();
+    return test::Result();
+}
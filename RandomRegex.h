@@ -0,0 +1,93 @@
+#pragma once
+
+#include <random>
+#include <string>
+
+//random expressions and texts over a few symbols for the tests that compare two ways of matching
+namespace automaton::test
+{
+    //what the generator may produce besides symbols, stars, alternatives and concatenations
+    struct RegexShape
+    {
+        bool groups = false;    //a parenthesised subexpression on its own
+        bool repeats = false;   //the same subexpression twice, as (r).(r)*
+    };
+
+    //builds the regex itself; a test that needs more about an expression passes its own builder with the same
+    //static functions
+    struct RegexText
+    {
+        using Result = std::string;
+
+        static std::string Symbol(char symbol)
+        {
+            return std::string(1, symbol);
+        }
+
+        static std::string Star(const std::string& body)
+        {
+            return "(" + body + ")*";
+        }
+
+        static std::string Alternative(const std::string& left, const std::string& right)
+        {
+            return "(" + left + "|" + right + ")";
+        }
+
+        static std::string Group(const std::string& inner)
+        {
+            return "(" + inner + ")";
+        }
+
+        static std::string Concat(const std::string& left, const std::string& right)
+        {
+            return left + "." + right;
+        }
+    };
+
+    //an expression over a, b and c nested up to depth levels
+    template<typename Builder = RegexText>
+    typename Builder::Result RandomRegex(std::mt19937& random, int depth, RegexShape shape = {})
+    {
+        auto symbol = Builder::Symbol(static_cast<char>('a' + random() % 3));
+        if (depth == 0)
+            return symbol;
+        auto next = [&] {
+            return RandomRegex<Builder>(random, depth - 1, shape);
+        };
+        switch (random() % 6) {
+        case 0:
+            return Builder::Star(next());
+        case 1: {
+            auto left = next();
+            return Builder::Alternative(left, next());
+        }
+        case 2:
+            if (shape.groups)
+                return Builder::Group(next());
+            [[fallthrough]];
+        case 3: {
+            auto left = next();
+            return Builder::Concat(left, next());
+        }
+        case 4:
+            if (shape.repeats) {
+                auto repeated = next();
+                return Builder::Concat(Builder::Group(repeated), Builder::Star(repeated));
+            }
+            [[fallthrough]];
+        default:
+            return symbol;
+        }
+    }
+
+    //up to maxLength symbols from the first symbols letters
+    inline std::string RandomText(std::mt19937& random, std::size_t maxLength, unsigned symbols)
+    {
+        std::string text(random() % (maxLength + 1), 'a');
+        for (auto& c : text) {
+            c = static_cast<char>('a' + random() % symbols);
+        }
+        return text;
+    }
+}
@@ -0,0 +1,438 @@
+#include "Scanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace automaton;
+
+namespace
+{
+    struct Source
+    {
+        std::string name;
+        std::size_t size = 0;
+        const char* data = nullptr;
+        void* mapping = nullptr;
+        std::string buffer;
+        bool failed = false;
+        bool streamed = false;  //scanned while it is read instead of by the workers
+        int fd = -1;            //stdin, pipes, FIFOs and devices are read from it, they cannot be mapped
+        bool ownsFd = false;
+        std::once_flag mapped;
+
+        //a FIFO only opens once it has a writer, so streams are opened when it is their turn
+        bool Open()
+        {
+            if (fd < 0) {
+                fd = open(name.c_str(), O_RDONLY);
+                ownsFd = fd >= 0;
+            }
+            return fd >= 0;
+        }
+
+        void Map()
+        {
+            std::call_once(mapped, [this] {
+                if (size == 0) {
+                    data = "";
+                    return;
+                }
+                int fd = open(name.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    failed = true;
+                    return;
+                }
+                mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                close(fd);
+                if (mapping == MAP_FAILED) {
+                    mapping = nullptr;
+                    failed = true;
+                    return;
+                }
+                madvise(mapping, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(mapping);
+            });
+        }
+
+        void Release()
+        {
+            if (mapping != nullptr)
+                munmap(mapping, size);
+            mapping = nullptr;
+            buffer.clear();
+            buffer.shrink_to_fit();
+            if (ownsFd)
+                close(fd);
+            fd = -1;
+            ownsFd = false;
+        }
+
+        ~Source()
+        {
+            Release();
+        }
+    };
+
+    struct Chunk
+    {
+        Source* source;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct Result
+    {
+        std::vector<std::pair<std::size_t, std::string_view>> matches; //record index inside the chunk, record
+        std::vector<std::string> fields;    //--extract: the groups of every match, separated by tabs
+        std::size_t records = 0;
+        std::size_t count = 0;
+        bool done = false;
+    };
+
+    bool MatchRecord(const Matcher& matcher, std::string_view record, const ScanOptions& options)
+    {
+        bool matched = options.wholeRecord ? matcher.Match(record) : matcher.Search(record);
+        return matched != options.invert;
+    }
+
+    //only records the plain DFA accepted get to the tagged one
+    std::string ExtractFields(const CaptureMatcher& extract, std::string_view record)
+    {
+        thread_local std::vector<Capture> groups;
+        std::string fields;
+        extract.Match(record, groups);
+        for (std::size_t group = 1; group < groups.size(); ++group) {
+            if (group > 1)
+                fields.push_back('\t');
+            if (groups[group].begin != Capture::npos)
+                fields.append(record.substr(groups[group].begin, groups[group].end - groups[group].begin));
+        }
+        return fields;
+    }
+
+    //a record belongs to the chunk it starts in, so a chunk skips the tail of the record it was cut through
+    void ScanChunk(const Matcher& matcher, const Chunk& chunk, Result& result, const ScanOptions& options)
+    {
+        Source& source = *chunk.source;
+        source.Map();
+        if (source.failed)
+            return;
+        const char* data = source.data;
+        bool keepRecords = !options.countOnly && !options.listFiles;
+
+        if (options.fileRecords) {
+            std::string_view record(data, source.size);
+            if (record.ends_with('\n'))
+                record.remove_suffix(1);
+            result.records = 1;
+            result.count = MatchRecord(matcher, record, options);
+            return;
+        }
+
+        std::size_t position = chunk.begin;
+        if (position > 0 && data[position - 1] != '\n') {
+            auto* newline = static_cast<const char*>(std::memchr(data + position, '\n', source.size - position));
+            position = newline ? newline - data + 1 : source.size;
+        }
+        while (position < chunk.end) {
+            auto* newline = static_cast<const char*>(std::memchr(data + position, '\n', source.size - position));
+            std::size_t stop = newline ? newline - data : source.size;
+            std::string_view record(data + position, stop - position);
+            if (MatchRecord(matcher, record, options)) {
+                result.count += 1;
+                if (keepRecords) {
+                    result.matches.emplace_back(result.records, record);
+                    if (options.extract)
+                        result.fields.push_back(ExtractFields(*options.extract, record));
+                }
+                else if (options.listFiles)
+                    break;
+            }
+            result.records += 1;
+            position = stop + 1;
+        }
+    }
+
+    //streams are scanned a block of whole lines at a time as they arrive, so a pipeline that never ends still
+    //gets its matches; the last record may lack its newline
+    template<typename Emit>
+    bool ScanStream(const Matcher& matcher, Source& source, const ScanOptions& options, Emit emit)
+    {
+        char block[1 << 16];
+        std::size_t total = 0;
+        std::call_once(source.mapped, [] {});
+        auto scan = [&](std::size_t size) {
+            source.data = source.buffer.data();
+            source.size = size;
+            Result result;
+            ScanChunk(matcher, {&source, 0, size}, result, options);
+            emit(result);
+            source.buffer.erase(0, size);
+            total += size;
+            return result.count > 0;
+        };
+
+        while (true) {
+            auto read = ::read(source.fd, block, sizeof(block));
+            if (read < 0 && errno == EINTR)
+                continue;
+            if (read < 0) {
+                source.size = total;
+                return false;
+            }
+            if (read == 0)
+                break;
+            source.buffer.append(block, static_cast<std::size_t>(read));
+            auto* newline = static_cast<const char*>(memrchr(block, '\n', static_cast<std::size_t>(read)));
+            if (newline == nullptr)
+                continue;
+            //-l only needs the first match
+            if (scan(source.buffer.size() - static_cast<std::size_t>(block + read - newline - 1)) && options.listFiles) {
+                source.size = total;
+                return true;
+            }
+        }
+        if (!source.buffer.empty())
+            scan(source.buffer.size());
+        source.size = total;
+        return true;
+    }
+
+    //-z needs the whole stream as one record
+    bool ReadStream(Source& source)
+    {
+        char block[1 << 16];
+        bool failed = false;
+        while (true) {
+            auto read = ::read(source.fd, block, sizeof(block));
+            if (read < 0 && errno == EINTR)
+                continue;
+            failed = read < 0;
+            if (read <= 0)
+                break;
+            source.buffer.append(block, static_cast<std::size_t>(read));
+        }
+        source.size = source.buffer.size();
+        source.data = source.buffer.data();
+        std::call_once(source.mapped, [] {});
+        return !failed;
+    }
+}
+
+int automaton::ScanInputs(const Matcher& matcher, const std::vector<std::string>& inputs, const ScanOptions& options)
+{
+    namespace fs = std::filesystem;
+    bool hadError = false;
+    bool showNames = inputs.size() > 1;
+    std::vector<std::unique_ptr<Source>> sources;
+
+    //-z reads a stream whole before the workers start, otherwise it is scanned when its output is due
+    auto addStream = [&](std::unique_ptr<Source> source) {
+        source->streamed = !options.fileRecords;
+        if (!source->streamed) {
+            if (!source->Open()) {
+                std::cerr << source->name << ": " << std::strerror(errno) << std::endl;
+                hadError = true;
+                return;
+            }
+            if (!ReadStream(*source)) {
+                std::cerr << source->name << ": read error" << std::endl;
+                hadError = true;
+            }
+        }
+        sources.push_back(std::move(source));
+    };
+
+    //only regular files are mapped and cut into chunks
+    auto addFile = [&](const fs::path& path) {
+        std::error_code error;
+        auto status = fs::status(path, error);
+        std::size_t size = 0;
+        if (!error && fs::is_regular_file(status))
+            size = fs::file_size(path, error);
+        if (error) {
+            std::cerr << path.string() << ": " << error.message() << std::endl;
+            hadError = true;
+            return;
+        }
+        auto source = std::make_unique<Source>();
+        source->name = path.string();
+        source->size = size;
+        if (fs::is_regular_file(status))
+            sources.push_back(std::move(source));
+        else addStream(std::move(source));
+    };
+
+    for (const auto& input : inputs.empty() ? std::vector<std::string>{"-"} : inputs) {
+        std::error_code error;
+        if (input == "-") {
+            auto source = std::make_unique<Source>();
+            source->name = "(standard input)";
+            source->fd = STDIN_FILENO;
+            addStream(std::move(source));
+        }
+        else if (fs::is_directory(input, error)) {
+            showNames = true;
+            std::vector<fs::path> files;
+            for (const auto& entry : fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied, error)) {
+                if (entry.is_regular_file(error))
+                    files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+            for (const auto& file : files) {
+                addFile(file);
+            }
+        }
+        else {
+            addFile(input);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Chunk> chunks;
+    for (const auto& source : sources) {
+        std::size_t size = source->size;
+        if (source->streamed)
+            continue;
+        if (options.fileRecords || size <= options.chunkSize) {
+            chunks.push_back({source.get(), 0, size});
+            continue;
+        }
+        for (std::size_t begin = 0; begin < size; begin += options.chunkSize) {
+            chunks.push_back({source.get(), begin, std::min(size, begin + options.chunkSize)});
+        }
+    }
+
+    std::vector<Result> results(chunks.size());
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<std::size_t> nextChunk = 0;
+    unsigned threadCount = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned>(std::min<std::size_t>(threadCount, std::max<std::size_t>(chunks.size(), 1)));
+
+    std::vector<std::jthread> workers;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([&] {
+            for (std::size_t index = nextChunk++; index < chunks.size(); index = nextChunk++) {
+                ScanChunk(matcher, chunks[index], results[index], options);
+                {
+                    std::lock_guard lock(mutex);
+                    results[index].done = true;
+                }
+                finished.notify_all();
+            }
+        });
+    }
+
+    //results are written in input order while the workers keep going
+    std::string output;
+    auto flush = [&output] {
+        std::fwrite(output.data(), 1, output.size(), stdout);
+        output.clear();
+    };
+
+    std::size_t totalBytes = 0;
+    std::size_t totalRecords = 0;
+    std::size_t totalMatches = 0;
+    std::size_t index = 0;
+    for (const auto& source : sources) {
+        std::size_t recordBase = 0;
+        std::size_t count = 0;
+        auto emit = [&](Result& result) {
+            for (std::size_t i = 0; i < result.matches.size(); ++i) {
+                const auto& [record, text] = result.matches[i];
+                if (showNames)
+                    output.append(source->name).push_back(':');
+                if (options.lineNumbers)
+                    output.append(std::to_string(recordBase + record + 1)).push_back(':');
+                output.append(options.extract ? result.fields[i] : text).push_back('\n');
+            }
+            recordBase += result.records;
+            count += result.count;
+            result.matches = {};
+            result.fields = {};
+        };
+
+        if (source->streamed && !source->Open()) {
+            flush();
+            std::cerr << source->name << ": " << std::strerror(errno) << std::endl;
+            hadError = true;
+            continue;
+        }
+        if (source->streamed) {
+            //the matches of every block are written before waiting for the next one
+            bool read = ScanStream(matcher, *source, options, [&](Result& result) {
+                emit(result);
+                if (!output.empty()) {
+                    flush();
+                    std::fflush(stdout);
+                }
+            });
+            if (!read) {
+                flush();
+                std::cerr << source->name << ": read error" << std::endl;
+                hadError = true;
+            }
+        }
+        for (; index < chunks.size() && chunks[index].source == source.get(); ++index) {
+            {
+                std::unique_lock lock(mutex);
+                finished.wait(lock, [&] { return results[index].done; });
+            }
+            emit(results[index]);
+            if (output.size() >= (1 << 20))
+                flush();
+        }
+
+        if (source->failed) {
+            flush();
+            std::cerr << source->name << ": cannot map file" << std::endl;
+            hadError = true;
+        }
+        else if (options.countOnly) {
+            if (showNames)
+                output.append(source->name).push_back(':');
+            output.append(std::to_string(count)).push_back('\n');
+        }
+        else if ((options.listFiles || options.fileRecords) && count > 0) {
+            output.append(source->name).push_back('\n');
+        }
+
+        totalBytes += source->size;
+        totalRecords += recordBase;
+        totalMatches += count;
+        source->Release();
+    }
+    flush();
+    std::fflush(stdout);
+    workers.clear();
+
+    if (options.stats) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double megabytes = static_cast<double>(totalBytes) / (1024.0 * 1024.0);
+        std::cerr << std::format("scanned {:.1f} MB in {:.3f} s ({:.1f} MB/s) with {} threads, {} records, {} matching\n",
+                                 megabytes,
+                                 elapsed.count(),
+                                 elapsed.count() > 0 ? megabytes / elapsed.count() : 0.0,
+                                 threadCount,
+                                 totalRecords,
+                                 totalMatches);
+    }
+
+    if (hadError)
+        return 2;
+    return totalMatches > 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Matcher.h"
+#include "Capture.h"
+#include <string>
+#include <vector>
+
+namespace automaton
+{
+    struct ScanOptions
+    {
+        bool wholeRecord = false;   //-x: the whole record has to be accepted, not just a part of it
+        bool fileRecords = false;   //-z: every file is a single record
+        bool invert = false;        //-v
+        bool countOnly = false;     //-c
+        bool listFiles = false;     //-l
+        bool lineNumbers = false;   //-n
+        bool stats = false;         //--stats: throughput on stderr
+        const CaptureMatcher* extract = nullptr;    //--extract: print the groups of the matching records instead
+        unsigned threads = 0;       //-j, 0 means one per hardware thread
+        std::size_t chunkSize = std::size_t{4} << 20;
+    };
+
+    //scans files, directory trees and stdin ("-") and prints the matching records in input order
+    //returns 0 if something matched, 1 if nothing did and 2 if an input could not be read
+    int ScanInputs(const Matcher& matcher, const std::vector<std::string>& inputs, const ScanOptions& options);
+}
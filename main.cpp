@@ -1,153 +1,509 @@
-﻿#include <iostream>
-#include "Automaton.h"
-#include "DFA.h"
-#include <fstream>
-#include <regex>
-#include <filesystem>
-
-automaton::Automaton* BuildAutomaton(const std::string& regex)
-{
-    using namespace automaton;
-    std::string polishFormRegex = RegexToPolishForm(regex);
-    std::stack<Automaton*> automatonStack;
-    std::uint16_t counter = 0;
-
-    //exciting stuff here!!
-
-    for(char character : polishFormRegex)
-    {
-        if(('a' <= character && character <= 'z')
-            || ('A' <= character && character <= 'Z')
-            || ('0' <= character && character <= '9'))
-        {
-            std::uint16_t next = counter + 1;
-            auto* automat = new Automaton{counter, next, character};
-            automatonStack.push(automat);
-        }
-
-        if(character == '*')
-        {
-            auto A = automatonStack.top();
-            automatonStack.pop();
-            auto* C = new Automaton{counter, static_cast<state>(counter + 1)};
-            C->Kleene(*A);
-            delete A;
-            automatonStack.push(C);
-        }
-
-        if(character == '.')
-        {
-            auto B = automatonStack.top();
-            automatonStack.pop();
-            auto A = automatonStack.top();
-            automatonStack.pop();
-
-            auto* C = new Automaton{*A, *B};
-            delete A;
-            delete B;
-            automatonStack.push(C);
-        }
-
-        if(character == '|')
-        {
-            auto B = automatonStack.top();
-            automatonStack.pop();
-            auto A = automatonStack.top();
-            automatonStack.pop();
-
-            auto* C = new Automaton{counter, static_cast<state>(counter + 1)};
-            C->TieAutomatons(*A, *B);
-            delete A;
-            delete B;
-            automatonStack.push(C);
-        }
-        counter += 2;
-    }
-
-    auto* finalAutomaton = automatonStack.top();
-    automatonStack.pop();
-    return finalAutomaton;
-}
-
-std::string ParsingRegex(const std::string& regex) {
-    std::string result = "";
-    for (auto character : regex) {
-        if (character != '.') {
-            result += character;
-        }
-    }
-    return result;
-}
-
-bool ValidateRegex(const std::string& regex) {
-    std::string toCheck = ParsingRegex(regex);
-    try {
-        std::regex re(toCheck);
-        return true;
-    }
-    catch (std::regex_error& e) {
-        return false;
-    }
-}
-
-int main()
-{
-    // std::string myRegex = "a.b.a.(a.a|b.b)*.c.(a.b)*";
-    // std::string myRegex = "(a.a|b)*.b.b";
-    std::ifstream fin("../input.txt");
-    if (!fin.is_open()) {
-        std::cerr << "Error opening file" << std::endl;
-        return 1;
-    }
-    if (!fout.is_open()) {
-        std::cerr << "Error opening file" << std::endl;
-        return 1;
-    }
-    std::string myRegex;
-    fin >> myRegex;
-    if (!ValidateRegex(myRegex))
-    {
-        std::cerr << "Input a valid regex :)";
-        return 1;
-    }
-    auto* myAutomaton = BuildAutomaton(myRegex);
-    std::cout << *myAutomaton;
-    automaton::DeterministicFiniteAutomaton myDFA(*myAutomaton);
-    bool in = true;
-    while(in)
-    {
-        system("clear");
-        std::cout << "Select one of the following options:" << std::endl;
-        std::cout << "1) Display the input regex\n";
-        std::cout << "2) Display the automata in terminal and output file\n";
-        std::cout << "3) Check if a word is accepted by the automata\n";
-        std::cout << "4) Exit\n";
-
-        int option;
-        std::cin >> option;
-
-        switch (option) {
-            case 1: {
-                std::cout << ParsingRegex(myRegex) << std::endl;
-                break;
-            }
-            case 2: {
-                myDFA.PrintAutomaton(std::cout);
-                break;
-            }
-            case 3: {
-                std::cout << "Input your word: ";
-                std::string word;
-                std::cin >> word;
-                if (myDFA.CheckWord(word))
-                    std::cout << "Valid word\n";
-                else std::cout << "Invalid word\n";
-                break;
-            }
-            default: {
-                in = false;
-            }
-        }
-
-    }
-}
+﻿#include <iostream>
+#include "Automaton.h"
+#include "DFA.h"
+#include "Matcher.h"
+#include "Scanner.h"
+#include "Daemon.h"
+#include "Equivalence.h"
+#include "Benchmark.h"
+#include <charconv>
+#include <deque>
+#include <fstream>
+#include <regex>
+#include <filesystem>
+
+void PrintUsage(std::ostream& os)
+{
+    os << "usage: AutomatFinit                          interactive menu, regex read from ../input.txt\n";
+    os << "       AutomatFinit [options] REGEX [FILE...]\n";
+    os << "       AutomatFinit [options] -e REGEX... [-f FILE] [FILE...]\n";
+    os << "       AutomatFinit --daemon SOCKET [-j N] [REGEX | -e REGEX... | -f FILE]\n";
+    os << "       AutomatFinit --client SOCKET [options] REGEX [FILE...]\n";
+    os << "       AutomatFinit --client SOCKET --rules [options] [FILE...]\n";
+    os << "       AutomatFinit --add-rule SOCKET REGEX\n";
+    os << "       AutomatFinit --remove-rule SOCKET ID\n";
+    os << "       AutomatFinit --daemon-stats SOCKET\n";
+    os << "       AutomatFinit --bench-layout CORPUS [-x] [--engine E] [--profile SAMPLE] REGEX\n";
+    os << "       AutomatFinit --bench-engines REGEX | -e REGEX... | -f FILE\n";
+    os << "       AutomatFinit --bench-extract CORPUS REGEX\n";
+    os << "inputs are files, directories (scanned recursively) or - for stdin (the default)\n";
+    os << "  -e REGEX   add a pattern, a record matches if any pattern does\n";
+    os << "  -f FILE    read patterns from FILE, one per line\n";
+    os << "  -x         the whole record has to be accepted by the automaton\n";
+    os << "  -z         every file is a single record, matching files are printed\n";
+    os << "  -v         select the records that do not match\n";
+    os << "  -c         print the number of matching records per input\n";
+    os << "  -l         print the names of inputs with a match\n";
+    os << "  -n         prefix records with their line number\n";
+    os << "  -j N       number of worker threads (default: one per core)\n";
+    os << "  --stats    report throughput on stderr\n";
+    os << "  --rules    match against the daemon's rule set instead of a pattern\n";
+    os << "  --extract  print the groups of whole-record matches, separated by tabs\n";
+    os << "  --dedup    drop patterns that are equivalent to or subsumed by another one before compiling\n";
+    os << "  --layout original|bfs\n";
+    os << "             numbering of the DFA states in the transition table (default: bfs)\n";
+    os << "  --engine thompson|derivative|glushkov\n";
+    os << "             how the DFA is built: from a lambda-NFA (default), from regex derivatives or from\n";
+    os << "             the lambda-free position automaton\n";
+    os << "  --profile FILE\n";
+    os << "             put the states visited most while scanning FILE first in the transition table\n";
+}
+
+//a whole non-negative decimal number that fits in 32 bits
+bool ParseNumber(const std::string& text, std::uint32_t& value)
+{
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && error == std::errc{} && end == text.data() + text.size();
+}
+
+//same output as the local scan, but the records are matched by a daemon in pipelined batches
+//an empty pattern list matches against the daemon's rule set; inputs and output are those of the batch mode
+int RunClient(const std::string& socketPath, const std::vector<std::string>& patterns,
+              const std::vector<std::string>& inputs, const automaton::ScanOptions& options)
+{
+    using namespace automaton;
+    constexpr std::size_t batchSize = 1024;
+    constexpr std::size_t maxInFlight = 8;
+    bool hadError = false;
+    std::size_t matches = 0;
+
+    try {
+        MatchClient client(socketPath);
+        auto patternId = patterns.empty() ? ruleSetPatternId : client.Compile(JoinAlternatives(patterns));
+        bool showNames = inputs.size() > 1;
+
+        //directories are scanned recursively in name order, like ScanInputs does
+        std::vector<std::string> files;
+        for (const auto& input : inputs.empty() ? std::vector<std::string>{"-"} : inputs) {
+            namespace fs = std::filesystem;
+            std::error_code error;
+            if (input == "-" || !fs::is_directory(input, error)) {
+                files.push_back(input);
+                continue;
+            }
+            showNames = true;
+            std::vector<fs::path> found;
+            for (const auto& entry : fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied, error)) {
+                if (entry.is_regular_file(error))
+                    found.push_back(entry.path());
+            }
+            std::sort(found.begin(), found.end());
+            for (const auto& file : found) {
+                files.push_back(file.string());
+            }
+        }
+
+        for (const auto& input : files) {
+            std::ifstream file;
+            std::istream* in = &std::cin;
+            std::string name = input == "-" ? "(standard input)" : input;
+            if (input != "-") {
+                file.open(input);
+                if (!file.is_open()) {
+                    std::cerr << "Error opening file " << input << std::endl;
+                    hadError = true;
+                    continue;
+                }
+                in = &file;
+            }
+
+            std::deque<std::pair<std::uint32_t, std::vector<std::string>>> inFlight;
+            std::vector<std::string> batch;
+            std::size_t lineNumber = 0;
+            std::size_t count = 0;
+            auto collect = [&] {
+                auto& [requestId, lines] = inFlight.front();
+                auto results = client.ReceiveMatch(requestId);
+                for (std::size_t i = 0; i < lines.size(); ++i) {
+                    if (results[i] == options.invert)
+                        continue;
+                    count += 1;
+                    if (options.countOnly || options.listFiles || options.fileRecords)
+                        continue;
+                    if (showNames)
+                        std::cout << name << ':';
+                    if (options.lineNumbers)
+                        std::cout << lineNumber + i + 1 << ':';
+                    std::cout << lines[i] << '\n';
+                }
+                lineNumber += lines.size();
+                inFlight.pop_front();
+            };
+            auto sendBatch = [&] {
+                std::vector<std::string_view> records(batch.begin(), batch.end());
+                auto requestId = client.SendMatch(patternId, options.wholeRecord, records);
+                inFlight.emplace_back(requestId, std::move(batch));
+                batch.clear();
+                if (inFlight.size() > maxInFlight)
+                    collect();
+            };
+
+            if (options.fileRecords) {
+                //-z: the whole input is one record
+                std::string record(std::istreambuf_iterator<char>(*in), {});
+                if (record.ends_with('\n'))
+                    record.pop_back();
+                batch.push_back(std::move(record));
+            }
+            std::string line;
+            while (!options.fileRecords && std::getline(*in, line)) {
+                batch.push_back(std::move(line));
+                if (batch.size() == batchSize)
+                    sendBatch();
+            }
+            if (!batch.empty())
+                sendBatch();
+            while (!inFlight.empty())
+                collect();
+
+            if (options.countOnly) {
+                if (showNames)
+                    std::cout << name << ':';
+                std::cout << count << '\n';
+            }
+            else if ((options.listFiles || options.fileRecords) && count > 0) {
+                std::cout << name << '\n';
+            }
+            matches += count;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    if (hadError)
+        return 2;
+    return matches > 0 ? 0 : 1;
+}
+
+int RunBatch(int argc, char** argv)
+{
+    using namespace automaton;
+    ScanOptions options;
+    std::vector<std::string> patterns;
+    std::vector<std::string> inputs;
+    bool patternGiven = false;
+    bool deduplicate = false;
+    bool useRules = false;
+    bool extract = false;
+    enum class Mode { Scan, Daemon, Client, DaemonStats, BenchLayout, BenchEngines, BenchExtract, AddRule, RemoveRule } mode = Mode::Scan;
+    std::string socketPath;
+    std::string benchCorpus;
+    std::uint32_t ruleId = 0;
+    CompileOptions compileOptions;
+    std::string profileSample;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto nextArgument = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << argument << " needs an argument\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (argument == "-h" || argument == "--help") {
+            PrintUsage(std::cout);
+            return 0;
+        }
+        if (argument == "-e") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            patterns.emplace_back(value);
+            patternGiven = true;
+        }
+        else if (argument == "-f") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            std::ifstream patternFile(value);
+            if (!patternFile.is_open()) {
+                std::cerr << "Error opening file " << value << std::endl;
+                return 2;
+            }
+            std::string line;
+            while (std::getline(patternFile, line)) {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!line.empty())
+                    patterns.push_back(line);
+            }
+            patternGiven = true;
+        }
+        else if (argument == "--daemon" || argument == "--client" || argument == "--daemon-stats" || argument == "--add-rule") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            socketPath = value;
+            mode = argument == "--daemon" ? Mode::Daemon
+                 : argument == "--client" ? Mode::Client
+                 : argument == "--add-rule" ? Mode::AddRule
+                 : Mode::DaemonStats;
+        }
+        else if (argument == "--remove-rule") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            socketPath = value;
+            value = nextArgument();
+            if (!value)
+                return 2;
+            if (!ParseNumber(value, ruleId)) {
+                std::cerr << "--remove-rule needs a rule id, not " << value << "\n";
+                return 2;
+            }
+            mode = Mode::RemoveRule;
+        }
+        else if (argument == "--bench-layout" || argument == "--bench-extract") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            benchCorpus = value;
+            mode = argument == "--bench-layout" ? Mode::BenchLayout : Mode::BenchExtract;
+        }
+        else if (argument == "--bench-engines") {
+            mode = Mode::BenchEngines;
+        }
+        else if (argument == "--engine") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            std::string engine = value;
+            if (engine == "thompson") compileOptions.engine = Engine::Thompson;
+            else if (engine == "derivative") compileOptions.engine = Engine::Derivative;
+            else if (engine == "glushkov") compileOptions.engine = Engine::Glushkov;
+            else {
+                std::cerr << "Unknown engine " << engine << "\n";
+                return 2;
+            }
+        }
+        else if (argument == "--layout") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            std::string layout = value;
+            if (layout == "original") compileOptions.layout = Layout::Original;
+            else if (layout == "bfs") compileOptions.layout = Layout::BreadthFirst;
+            else {
+                std::cerr << "Unknown layout " << layout << "\n";
+                return 2;
+            }
+        }
+        else if (argument == "--profile") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            std::ifstream sampleFile(value, std::ios::binary);
+            if (!sampleFile.is_open()) {
+                std::cerr << "Error opening file " << value << std::endl;
+                return 2;
+            }
+            profileSample.assign(std::istreambuf_iterator<char>(sampleFile), std::istreambuf_iterator<char>());
+            compileOptions.layout = Layout::Profile;
+        }
+        else if (argument == "-j") {
+            auto value = nextArgument();
+            if (!value)
+                return 2;
+            std::uint32_t threads;
+            if (!ParseNumber(value, threads)) {
+                std::cerr << "-j needs a number of threads, not " << value << "\n";
+                return 2;
+            }
+            options.threads = threads;
+        }
+        else if (argument == "-x") options.wholeRecord = true;
+        else if (argument == "-z") options.fileRecords = true;
+        else if (argument == "-v") options.invert = true;
+        else if (argument == "-c") options.countOnly = true;
+        else if (argument == "-l") options.listFiles = true;
+        else if (argument == "-n") options.lineNumbers = true;
+        else if (argument == "--stats") options.stats = true;
+        else if (argument == "--dedup") deduplicate = true;
+        else if (argument == "--extract") extract = true;
+        else if (argument == "--rules") {
+            useRules = true;
+            patternGiven = true;
+        }
+        else if (argument.size() > 1 && argument.front() == '-') {
+            std::cerr << "Unknown option " << argument << "\n";
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        else if (!patternGiven) {
+            patterns.push_back(argument);
+            patternGiven = true;
+        }
+        else inputs.push_back(argument);
+    }
+
+    if (mode == Mode::DaemonStats || mode == Mode::RemoveRule) {
+        try {
+            MatchClient client(socketPath);
+            if (mode == Mode::DaemonStats)
+                std::cout << client.Stats();
+            else client.RemoveRule(ruleId);
+            return 0;
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 2;
+        }
+    }
+    compileOptions.sample = profileSample;
+    if (useRules && (mode != Mode::Client || !patterns.empty())) {
+        std::cerr << "--rules only works with --client and without patterns\n";
+        return 2;
+    }
+    if (patterns.empty() && mode != Mode::Daemon && !useRules) {
+        PrintUsage(std::cerr);
+        return 2;
+    }
+    for (const auto& pattern : patterns) {
+        if (!ValidateRegex(pattern)) {
+            std::cerr << "Input a valid regex :) " << pattern << std::endl;
+            return 2;
+        }
+    }
+
+    //the groups are numbered in the pattern as written, JoinAlternatives would add its own
+    if (extract && (mode != Mode::Scan || patterns.size() != 1 || options.invert || options.fileRecords)) {
+        std::cerr << "--extract needs a single pattern and does not work with -v or -z\n";
+        return 2;
+    }
+
+    if (deduplicate && mode != Mode::Daemon) {
+        //daemon pattern ids are positions, so the daemon keeps every pattern it was given
+        auto total = patterns.size();
+        try {
+            patterns = DeduplicatePatterns(patterns, compileOptions.engine);
+        }
+        catch (const std::length_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 2;
+        }
+        if (options.stats)
+            std::cerr << "dedup kept " << patterns.size() << " of " << total << " patterns\n";
+    }
+
+    if (mode == Mode::AddRule) {
+        if (patterns.size() != 1 || !inputs.empty()) {
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        try {
+            MatchClient client(socketPath);
+            std::cout << client.AddRule(patterns.front()) << '\n';
+            return 0;
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 2;
+        }
+    }
+    if (mode == Mode::BenchLayout) {
+        return BenchmarkLayouts(JoinAlternatives(patterns), benchCorpus, options.wholeRecord, compileOptions);
+    }
+    if (mode == Mode::BenchEngines) {
+        return BenchmarkEngines(patterns);
+    }
+    if (mode == Mode::BenchExtract) {
+        return BenchmarkExtraction(JoinAlternatives(patterns), benchCorpus);
+    }
+    if (mode == Mode::Daemon) {
+        if (!inputs.empty()) {
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        return RunDaemon(socketPath, patterns, DaemonOptions{options.threads, compileOptions.engine});
+    }
+    if (mode == Mode::Client) {
+        return RunClient(socketPath, patterns, inputs, options);
+    }
+
+    try {
+        auto matcher = CompileRegex(JoinAlternatives(patterns), compileOptions);
+        if (!extract)
+            return ScanInputs(matcher, inputs, options);
+        CaptureMatcher captureMatcher(patterns.front());
+        options.extract = &captureMatcher;
+        options.wholeRecord = true;
+        return ScanInputs(matcher, inputs, options);
+    }
+    catch (const std::length_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        return RunBatch(argc, argv);
+    }
+
+    // std::string myRegex = "a.b.a.(a.a|b.b)*.c.(a.b)*";
+    // std::string myRegex = "(a.a|b)*.b.b";
+    std::ifstream fin("../input.txt");
+    std::ofstream fout("../output.txt");
+    if (!fin.is_open()) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    if (!fout.is_open()) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    std::string myRegex;
+    fin >> myRegex;
+    if (!ValidateRegex(myRegex))
+    {
+        std::cerr << "Input a valid regex :)";
+        return 1;
+    }
+    auto* myAutomaton = automaton::BuildAutomaton(myRegex);
+    std::cout << *myAutomaton;
+    automaton::DeterministicFiniteAutomaton myDFA(*myAutomaton);
+    bool in = true;
+    while(in)
+    {
+        system("clear");
+        std::cout << "Select one of the following options:" << std::endl;
+        std::cout << "1) Display the input regex\n";
+        std::cout << "2) Display the automata in terminal and output file\n";
+        std::cout << "3) Check if a word is accepted by the automata\n";
+        std::cout << "4) Exit\n";
+
+        int option;
+        std::cin >> option;
+
+        switch (option) {
+            case 1: {
+                std::cout << ParsingRegex(myRegex) << std::endl;
+                break;
+            }
+            case 2: {
+                myDFA.PrintAutomaton(std::cout);
+                myDFA.PrintAutomaton(fout);
+                break;
+            }
+            case 3: {
+                std::cout << "Input your word: ";
+                std::string word;
+                std::cin >> word;
+                if (myDFA.CheckWord(word))
+                    std::cout << "Valid word\n";
+                else std::cout << "Invalid word\n";
+                break;
+            }
+            default: {
+                in = false;
+            }
+        }
+
+    }
+    delete myAutomaton;
+}